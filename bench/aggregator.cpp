@@ -0,0 +1,111 @@
+// Message rate of 16-byte updates to random ranks: one send per record against the aggregator.
+// mpirun -np P bench_aggregator [records per rank] [batch records]
+#include <cstdlib>
+#include <mpi.hpp>
+#include <random>
+#include <vector>
+
+struct update
+{
+    long key;
+    double value;
+    static MPI_Datatype mpi_type()
+    {
+        static const MPI_Datatype type = []() {
+            MPI_Datatype t;
+            MPI_Type_contiguous(sizeof(update), MPI_BYTE, &t);
+            return mpi::commit_type(t);
+        }();
+        return type;
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    mpi::environment env(argc, argv);
+    mpi::log_init(mpi::LogLevel::Info);
+
+    using mpi::world;
+
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    std::size_t batch = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4096;
+    std::mt19937 rng(world.rank());
+    std::uniform_int_distribution<int> pick(0, world.size() - 1);
+    std::vector<int> dests(n);
+    for (auto &d : dests)
+    {
+        d = pick(rng);
+    }
+    double checksum = 0;
+
+    // direct: counts first so every rank knows how many records to receive.
+    {
+        std::vector<int> send_counts(world.size(), 0), recv_counts(world.size());
+        for (int d : dests)
+        {
+            ++send_counts[d];
+        }
+        world.barrier();
+        double start = MPI_Wtime();
+        world.alltoall(send_counts.data(), recv_counts.data());
+        int expected = 0;
+        for (int c : recv_counts)
+        {
+            expected += c;
+        }
+        std::vector<update> inbox(expected);
+        std::vector<mpi::request> recvs;
+        recvs.reserve(expected);
+        for (int i = 0; i < expected; ++i)
+        {
+            recvs.push_back(world.irecv(&inbox[i], 1, MPI_ANY_SOURCE, 0));
+        }
+        std::vector<update> outbox(n);
+        std::vector<mpi::request> sends;
+        sends.reserve(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            outbox[i] = update{long(i), 1.0};
+            sends.push_back(world.isend(&outbox[i], 1, dests[i], 0));
+        }
+        mpi::wait_all(sends);
+        mpi::wait_all(recvs);
+        double elapsed = MPI_Wtime() - start, slowest;
+        world.allreduce(elapsed, slowest, mpi::op::max());
+        if (world.rank() == 0)
+        {
+            mpi::log_info("direct send   : ", n * world.size() / slowest / 1e6, " Mrecords/s");
+        }
+    }
+
+    // aggregated
+    {
+        mpi::flush_policy policy;
+        policy.max_records = batch;
+        mpi::aggregator<update> agg(
+            world,
+            [&](int, const update *records, std::size_t count) {
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    checksum += records[i].value;
+                }
+            },
+            policy);
+        world.barrier();
+        double start = MPI_Wtime();
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            agg.push(dests[i], update{long(i), 1.0});
+        }
+        agg.finish();
+        double elapsed = MPI_Wtime() - start, slowest, total;
+        world.allreduce(elapsed, slowest, mpi::op::max());
+        world.allreduce(checksum, total, mpi::op::sum());
+        if (world.rank() == 0)
+        {
+            mpi::log_info("aggregated    : ", n * world.size() / slowest / 1e6, " Mrecords/s, batch = ", batch,
+                          ", delivered = ", total, ", batches sent by rank 0 = ", agg.stats().batches_sent);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+// Receive buffers: a fresh std::vector per message (allocation and zero-fill) against mpi::buffer (pooled blocks and
+// no fill), and sends from MPI_Alloc_mem memory against std::allocator memory.
+// mpirun -np 2 bench_buffer [iterations]
+#include <cstdlib>
+#include <mpi.hpp>
+#include <vector>
+
+template <typename Vector>
+double resize_time(std::size_t n, int iterations)
+{
+    double checksum = 0;
+    double start = MPI_Wtime();
+    for (int i = 0; i < iterations; ++i)
+    {
+        Vector v;
+        v.resize(n);
+        v[n - 1] = i;
+        checksum += v[n - 1];
+    }
+    double elapsed = (MPI_Wtime() - start) / iterations;
+    return checksum < 0 ? 0 : elapsed; // keeps the loop
+}
+
+// rank 0 sends `iterations` messages, rank 1 receives each one into a new container
+template <typename Vector>
+double recv_time(const std::vector<double> &message, int iterations)
+{
+    const auto &world = mpi::world;
+    world.barrier();
+    double start = MPI_Wtime();
+    for (int i = 0; i < iterations; ++i)
+    {
+        if (world.rank() == 0)
+        {
+            world.send(message, 1, 0);
+        }
+        else
+        {
+            Vector v;
+            world.recv(v, 0, 0);
+        }
+        if (i % 16 == 15)
+            world.barrier(); // keeps the sender from running ahead
+    }
+    return (MPI_Wtime() - start) / iterations;
+}
+
+template <typename Vector>
+double pingpong_time(std::size_t n, int iterations)
+{
+    const auto &world = mpi::world;
+    Vector data(n);
+    world.barrier();
+    double start = MPI_Wtime();
+    for (int i = 0; i < iterations; ++i)
+    {
+        if (world.rank() == 0)
+        {
+            world.send(data.data(), n, 1, 0);
+            world.recv(data.data(), n, 1, 0);
+        }
+        else
+        {
+            world.recv(data.data(), n, 0, 0);
+            world.send(data.data(), n, 0, 0);
+        }
+    }
+    return (MPI_Wtime() - start) / (2 * iterations);
+}
+
+int main(int argc, char *argv[])
+{
+    mpi::environment env(argc, argv);
+    mpi::log_init(mpi::LogLevel::Info);
+
+    using mpi::world;
+
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200;
+    if (world.size() != 2)
+    {
+        if (world.rank() == 0)
+            mpi::log_error("needs 2 ranks");
+        return 1;
+    }
+
+    for (std::size_t n : {std::size_t(128), std::size_t(1) << 14, std::size_t(1) << 20})
+    {
+        double plain = resize_time<std::vector<double>>(n, iterations);
+        double pooled = resize_time<mpi::buffer<double>>(n, iterations);
+        std::vector<double> message(n, 1.0);
+        double recv_plain = recv_time<std::vector<double>>(message, iterations);
+        double recv_pooled = recv_time<mpi::buffer<double>>(message, iterations);
+        double pp_plain = pingpong_time<std::vector<double>>(n, iterations);
+        double pp_alloc_mem = pingpong_time<std::vector<double, mpi::alloc_mem_allocator<double>>>(n, iterations);
+        if (world.rank() == 1)
+        {
+            mpi::log_info(n * sizeof(double), " bytes: allocate + resize ", plain * 1e6, " us -> ", pooled * 1e6,
+                          " us, receive into a new container ", recv_plain * 1e6, " us -> ", recv_pooled * 1e6,
+                          " us, one-way latency ", pp_plain * 1e6, " us -> ", pp_alloc_mem * 1e6,
+                          " us with MPI_Alloc_mem");
+        }
+    }
+    if (world.rank() == 1)
+    {
+        auto stats = mpi::buffer_pool::instance().stats();
+        mpi::log_info("buffer pool: ", stats.hits, " hits, ", stats.misses, " misses, ", stats.cached_bytes,
+                      " bytes cached");
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+// Compressed transport on smooth (a sampled sine) and random doubles: compression ratio, codec CPU cost and the
+// effective bandwidth (uncompressed bytes per second) of send and broadcast against the plain calls.
+// mpirun -np P bench_compress [doubles] [repetitions]
+#include <cmath>
+#include <cstdlib>
+#include <mpi.hpp>
+#include <random>
+#include <vector>
+
+int main(int argc, char *argv[])
+{
+    mpi::environment env(argc, argv);
+    mpi::log_init(mpi::LogLevel::Info);
+
+    using mpi::world;
+
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::size_t(1) << 21;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 10;
+    const double bytes = n * sizeof(double);
+    const int last = world.size() - 1;
+
+    std::vector<double> smooth(n), noise(n), scratch(n);
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        smooth[i] = std::sin(i * 1e-4) * 100.0;
+        noise[i] = uniform(rng);
+    }
+
+    auto timed = [&](auto run) {
+        run();
+        world.barrier();
+        double start = MPI_Wtime();
+        for (int i = 0; i < repetitions; ++i)
+        {
+            run();
+        }
+        double elapsed = (MPI_Wtime() - start) / repetitions, slowest;
+        world.allreduce(elapsed, slowest, mpi::op::max());
+        return slowest;
+    };
+
+    for (auto [name, data] : {std::pair{"smooth", &smooth}, std::pair{"random", &noise}})
+    {
+        mpi::buffer<std::byte> encoded;
+        double encode = timed([&]() {
+            encoded.clear();
+            mpi::compress(data->data(), n, encoded);
+        });
+        double decode = timed([&]() { mpi::decompress(encoded.data(), encoded.size(), scratch.data(), n); });
+
+        double plain_send = timed([&]() {
+            if (world.rank() == 0)
+                world.send(data->data(), n, last, 0);
+            else if (world.rank() == last)
+                world.recv(scratch.data(), n, 0, 0);
+        });
+        double packed_send = timed([&]() {
+            if (world.rank() == 0)
+                mpi::compressed_send(world, data->data(), n, last, 0);
+            else if (world.rank() == last)
+                mpi::compressed_recv(world, scratch.data(), n, 0, 0);
+        });
+        double plain_bcast = timed([&]() {
+            scratch = *data;
+            world.broadcast(scratch.data(), n, 0);
+        });
+        double packed_bcast = timed([&]() {
+            scratch = *data;
+            mpi::compressed_broadcast(world, scratch.data(), n, 0);
+        });
+
+        if (world.rank() == 0)
+        {
+            mpi::log_info(name, ": ratio ", bytes / encoded.size(), ", compress ", bytes / encode / 1e9,
+                          " GB/s, decompress ", bytes / decode / 1e9, " GB/s");
+            mpi::log_info(name, ": send ", bytes / plain_send / 1e9, " -> ", bytes / packed_send / 1e9,
+                          " GB/s, broadcast ", bytes / plain_bcast / 1e9, " -> ", bytes / packed_bcast / 1e9,
+                          " GB/s effective");
+        }
+    }
+    return 0;
+}
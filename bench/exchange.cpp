@@ -0,0 +1,75 @@
+// Sparse exchange with a few random peers per rank: NBX against an alltoall of counts followed by point-to-point.
+// mpirun -np P bench_exchange [peers per rank] [doubles per message]
+#include <cstdlib>
+#include <map>
+#include <mpi.hpp>
+#include <random>
+#include <vector>
+
+using payload_map = std::map<int, std::vector<double>>;
+
+payload_map alltoall_exchange(const mpi::communicator &comm, const payload_map &outgoing, int tag)
+{
+    std::vector<int> send_counts(comm.size(), 0), recv_counts(comm.size());
+    for (const auto &[dest, payload] : outgoing)
+    {
+        send_counts[dest] = static_cast<int>(payload.size()) + 1; // + 1: an empty payload is still a message
+    }
+    comm.alltoall(send_counts.data(), recv_counts.data());
+    payload_map incoming;
+    std::vector<mpi::request> requests;
+    for (int src = 0; src < comm.size(); ++src)
+    {
+        if (recv_counts[src] > 0)
+        {
+            auto &payload = incoming[src];
+            payload.resize(recv_counts[src] - 1);
+            requests.push_back(comm.irecv(payload.data(), payload.size(), src, tag));
+        }
+    }
+    for (const auto &[dest, payload] : outgoing)
+    {
+        requests.push_back(comm.isend(payload.data(), payload.size(), dest, tag));
+    }
+    mpi::wait_all(requests);
+    return incoming;
+}
+
+int main(int argc, char *argv[])
+{
+    mpi::environment env(argc, argv);
+    mpi::log_init(mpi::LogLevel::Info);
+
+    using mpi::world;
+
+    int peers = argc > 1 ? std::atoi(argv[1]) : 4;
+    std::size_t size = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 64;
+    std::mt19937 rng(world.rank());
+    std::uniform_int_distribution<int> pick(0, world.size() - 1);
+    payload_map outgoing;
+    for (int i = 0; i < peers; ++i)
+    {
+        outgoing[pick(rng)] = std::vector<double>(size, world.rank());
+    }
+
+    const int repeat = 50;
+    auto run = [&](const char *name, auto &&exchange) {
+        world.barrier();
+        double start = MPI_Wtime();
+        std::size_t received = 0;
+        for (int i = 0; i < repeat; ++i)
+        {
+            received += exchange(i % 2).size();
+        }
+        double elapsed = (MPI_Wtime() - start) / repeat, slowest;
+        world.allreduce(elapsed, slowest, mpi::op::max());
+        if (world.rank() == 0)
+        {
+            mpi::log_info(name, ": ranks = ", world.size(), ", peers = ", peers, ", time = ", slowest * 1e6,
+                          " us per exchange, rank 0 received from ", received / repeat, " ranks");
+        }
+    };
+    run("NBX               ", [&](int round) { return mpi::sparse_exchange(world, outgoing, 100 + round); });
+    run("alltoall of counts", [&](int round) { return alltoall_exchange(world, outgoing, 100 + round); });
+    return 0;
+}
@@ -0,0 +1,106 @@
+// Threads produce the partitions of a send buffer, partition k taking k + 1 units of work. Join-then-send starts one
+// isend after the last thread; partitioned_send lets every partition leave as soon as its thread is done.
+// mpirun -np 2 bench_partitioned [threads] [doubles per partition] [iterations]
+#include <cmath>
+#include <cstdlib>
+#include <mpi.hpp>
+#include <thread>
+#include <vector>
+
+void produce(double *part, std::size_t count, std::size_t work)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        double v = static_cast<double>(i);
+        for (std::size_t w = 0; w < work; ++w)
+        {
+            v = std::sqrt(v + 1.0);
+        }
+        part[i] = v;
+    }
+}
+
+// seconds per round, measured on the receiver from the common start to the last byte
+double round_time(bool partitioned, std::size_t threads, std::size_t count, int iterations)
+{
+    const auto &world = mpi::world;
+    std::vector<double> data(threads * count);
+    double elapsed = 0;
+    if (world.rank() == 0)
+    {
+        mpi::partitioned_send<double> out(world, data.data(), threads, count, 1, 0);
+        for (int i = 0; i < iterations; ++i)
+        {
+            world.barrier();
+            if (partitioned)
+                out.start();
+            std::vector<std::thread> producers;
+            for (std::size_t k = 0; k < threads; ++k)
+            {
+                producers.emplace_back([&, k]() {
+                    produce(data.data() + k * count, count, k + 1);
+                    if (partitioned)
+                        out.ready(k);
+                });
+            }
+            for (auto &t : producers)
+            {
+                t.join();
+            }
+            if (partitioned)
+                out.wait();
+            else
+                world.send(data.data(), data.size(), 1, 1000);
+        }
+    }
+    else
+    {
+        mpi::partitioned_recv<double> in(world, data.data(), threads, count, 0, 0);
+        for (int i = 0; i < iterations; ++i)
+        {
+            world.barrier();
+            double start = MPI_Wtime();
+            if (partitioned)
+            {
+                in.start();
+                in.wait();
+            }
+            else
+            {
+                world.recv(data.data(), data.size(), 0, 1000);
+            }
+            elapsed += MPI_Wtime() - start;
+        }
+    }
+    return elapsed / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    mpi::environment env(argc, argv, mpi::thread_level::multiple);
+    mpi::log_init(mpi::LogLevel::Info);
+
+    using mpi::world;
+
+    std::size_t threads = argc > 1 ? std::atoi(argv[1]) : 4;
+    std::size_t count = argc > 2 ? std::atoi(argv[2]) : 1 << 16;
+    int iterations = argc > 3 ? std::atoi(argv[3]) : 20;
+    if (world.size() != 2 || env.provided() != mpi::thread_level::multiple)
+    {
+        if (world.rank() == 0)
+            mpi::log_error("needs 2 ranks and MPI_THREAD_MULTIPLE");
+        return 1;
+    }
+
+#ifdef MPICPP_PARTITIONED
+    const char *implementation = "MPI-4 partitioned";
+#else
+    const char *implementation = "persistent per-partition emulation";
+#endif
+    double joined = round_time(false, threads, count, iterations);
+    double partitioned = round_time(true, threads, count, iterations);
+    if (world.rank() == 1)
+        mpi::log_info(threads, " x ", count * sizeof(double), " bytes: join then send ", joined * 1e3, " ms, ",
+                      implementation, " ", partitioned * 1e3, " ms");
+    return 0;
+}
@@ -0,0 +1,66 @@
+// Pipelined broadcast/reduce against single-shot MPI_Bcast/MPI_Reduce, sweeping the segment size.
+// mpirun -np P bench_pipeline [megabytes]
+#include <cstdlib>
+#include <mpi.hpp>
+#include <vector>
+
+template <typename F>
+double best_time(F &&f)
+{
+    using mpi::world;
+    double best = 1e300;
+    for (int i = 0; i < 5; ++i)
+    {
+        world.barrier();
+        double start = MPI_Wtime();
+        f();
+        double elapsed = MPI_Wtime() - start, slowest;
+        world.allreduce(elapsed, slowest, mpi::op::max());
+        best = std::min(best, slowest);
+    }
+    return best;
+}
+
+void report(const char *name, std::size_t segment, std::size_t bytes, double seconds)
+{
+    if (mpi::world.rank() == 0)
+    {
+        mpi::log_info(name, ": segment = ", segment / 1024, " KiB, time = ", seconds * 1e3,
+                      " ms, bandwidth = ", bytes / seconds / 1e9, " GB/s");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    mpi::environment env(argc, argv);
+    mpi::log_init(mpi::LogLevel::Info);
+
+    using mpi::world;
+
+    std::size_t megabytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 256;
+    std::size_t count = megabytes * 1024 * 1024 / sizeof(double);
+    std::size_t bytes = count * sizeof(double);
+    std::vector<double> data(count, world.rank()), result(count);
+
+    report("MPI_Bcast            ", bytes, bytes, best_time([&]() { world.broadcast(data.data(), count, 0); }));
+    report("MPI_Reduce           ", bytes, bytes,
+           best_time([&]() { world.reduce(data.data(), result.data(), count, mpi::op::sum(), 0); }));
+    for (std::size_t segment = 16 * 1024; segment <= 16 * 1024 * 1024 && segment <= bytes; segment *= 4)
+    {
+        report("broadcast, chain     ", segment, bytes, best_time([&]() {
+                   mpi::pipelined_broadcast(world, data.data(), count, 0, segment, mpi::pipeline::chain);
+               }));
+        report("broadcast, tree      ", segment, bytes, best_time([&]() {
+                   mpi::pipelined_broadcast(world, data.data(), count, 0, segment, mpi::pipeline::binary_tree);
+               }));
+        report("reduce, chain        ", segment, bytes, best_time([&]() {
+                   mpi::pipelined_reduce(world, data.data(), result.data(), count, mpi::op::sum(), 0, segment,
+                                         mpi::pipeline::chain);
+               }));
+        report("reduce, tree         ", segment, bytes, best_time([&]() {
+                   mpi::pipelined_reduce(world, data.data(), result.data(), count, mpi::op::sum(), 0, segment,
+                                         mpi::pipeline::binary_tree);
+               }));
+    }
+    return 0;
+}
@@ -0,0 +1,99 @@
+// Overlap of a large iallreduce and a large isend/irecv with a compute kernel, with and without the progress engine.
+// overlap = (communication + compute - total) / min(communication, compute), 1 is perfect overlap.
+// mpirun -np P bench_progress [doubles] [progress thread cpu] [polling interval us]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <mpi.hpp>
+#include <vector>
+
+// busy work which does not call MPI, so it cannot progress anything
+void compute(double seconds)
+{
+    auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+    while (std::chrono::steady_clock::now() < end)
+    {
+    }
+}
+
+double slowest(double local)
+{
+    double result;
+    mpi::world.allreduce(local, result, mpi::op::max());
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    mpi::environment env(argc, argv, mpi::thread_level::multiple);
+    mpi::log_init(mpi::LogLevel::Info);
+
+    using mpi::world;
+
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::size_t(1) << 22;
+    mpi::progress_options options;
+    options.cpu = argc > 2 ? std::atoi(argv[2]) : -1;
+    options.interval = std::chrono::microseconds(argc > 3 ? std::atoi(argv[3]) : 20);
+    if (env.provided() != mpi::thread_level::multiple)
+    {
+        if (world.rank() == 0)
+            mpi::log_error("needs MPI_THREAD_MULTIPLE, provided ", mpi::to_string(env.provided()));
+        return 1;
+    }
+
+    std::vector<double> send(n, 1.0), recv(n), incoming(n);
+    const int peer = world.rank() ^ 1;
+    const bool paired = peer < world.size();
+    auto start = [&]() {
+        std::vector<mpi::request> reqs;
+        reqs.push_back(world.iallreduce(send.data(), recv.data(), n, mpi::op::sum()));
+        if (paired)
+        {
+            reqs.push_back(world.irecv(incoming.data(), n, peer, 0));
+            reqs.push_back(world.isend(send.data(), n, peer, 0));
+        }
+        return reqs;
+    };
+    auto timed = [&](auto body) {
+        world.barrier();
+        double t0 = MPI_Wtime();
+        body();
+        return slowest(MPI_Wtime() - t0);
+    };
+
+    double t_comm = timed([&]() {
+        auto reqs = start();
+        mpi::wait_all(reqs);
+    });
+    double t_compute = t_comm;
+    double t_plain = timed([&]() {
+        auto reqs = start();
+        compute(t_compute);
+        mpi::wait_all(reqs);
+    });
+    double t_engine;
+    {
+        mpi::progress_engine engine(options);
+        t_engine = timed([&]() {
+            std::vector<mpi::completion> done;
+            for (auto &req : start())
+            {
+                done.push_back(engine.submit(std::move(req)));
+            }
+            compute(t_compute);
+            for (auto &c : done)
+            {
+                c.wait();
+            }
+        });
+    }
+
+    auto overlap = [&](double total) { return (t_comm + t_compute - total) / std::min(t_comm, t_compute); };
+    if (world.rank() == 0)
+    {
+        mpi::log_info(n, " doubles, communication = ", t_comm, " s, compute = ", t_compute, " s");
+        mpi::log_info("without progress thread: total = ", t_plain, " s, overlap = ", overlap(t_plain));
+        mpi::log_info("with progress thread   : total = ", t_engine, " s, overlap = ", overlap(t_engine));
+    }
+    return 0;
+}
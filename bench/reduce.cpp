@@ -0,0 +1,131 @@
+// Allreduce throughput of builtin ops, the old element-wise user op callback and the block kernels of reduction.hpp.
+// mpirun -np P bench_reduce [max elements]
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <mpi.hpp>
+#include <random>
+#include <vector>
+
+// the user op callback as it was before the block kernels: default-constructed functor, std::transform.
+template <typename T, typename Func>
+void legacy_callback(void *invec, void *inoutvec, int *len, MPI_Datatype *)
+{
+    T *in = static_cast<T *>(invec);
+    T *out = static_cast<T *>(inoutvec);
+    Func func;
+    std::transform(in, in + *len, out, out, func);
+}
+
+template <typename T, typename Func>
+MPI_Op legacy_op()
+{
+    MPI_Op op;
+    MPI_Op_create(&legacy_callback<T, Func>, true, &op);
+    return op;
+}
+
+template <typename T>
+double time_allreduce(const std::vector<T> &send, std::vector<T> &recv, MPI_Op op)
+{
+    using mpi::world;
+    const int repeat = 10;
+    world.allreduce(send.data(), recv.data(), send.size(), op); // warm up
+    world.barrier();
+    double start = MPI_Wtime();
+    for (int i = 0; i < repeat; ++i)
+    {
+        world.allreduce(send.data(), recv.data(), send.size(), op);
+    }
+    double elapsed = (MPI_Wtime() - start) / repeat, slowest;
+    world.allreduce(elapsed, slowest, mpi::op::max());
+    return slowest;
+}
+
+template <typename T>
+void report(const char *name, std::size_t n, double seconds)
+{
+    if (mpi::world.rank() == 0)
+    {
+        mpi::log_info(name, ": n = ", n, ", time = ", seconds * 1e3, " ms, ", n * sizeof(T) / seconds / 1e9, " GB/s");
+    }
+}
+
+struct plain_plus
+{
+    double operator()(double a, double b) const { return a + b; }
+};
+
+struct plain_absmax
+{
+    double operator()(double a, double b) const { return std::max(std::abs(a), std::abs(b)); }
+};
+
+int main(int argc, char *argv[])
+{
+    mpi::environment env(argc, argv);
+    mpi::log_init(mpi::LogLevel::Info);
+
+    using mpi::world;
+
+    std::size_t max_n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : (1 << 22);
+    std::mt19937_64 rng(world.rank());
+    std::normal_distribution<double> dist;
+
+    MPI_Op legacy_sum = legacy_op<double, plain_plus>();
+    MPI_Op legacy_absmax = legacy_op<double, plain_absmax>();
+
+    for (std::size_t n = 1024; n <= max_n; n *= 8)
+    {
+        std::vector<double> x(n), y(n);
+        std::generate(x.begin(), x.end(), [&]() { return dist(rng); });
+        report<double>("sum     builtin MPI_SUM       ", n, time_allreduce(x, y, MPI_SUM));
+        report<double>("sum     legacy callback       ", n, time_allreduce(x, y, legacy_sum));
+        report<double>("sum     user op, scalar loop  ", n,
+                       time_allreduce(x, y, mpi::op::custom<double, plain_plus>(true)));
+        report<double>("absmax  builtin MPI_MAX       ", n, time_allreduce(x, y, MPI_MAX));
+        report<double>("absmax  legacy callback       ", n, time_allreduce(x, y, legacy_absmax));
+        report<double>("absmax  block kernel          ", n,
+                       time_allreduce(x, y, mpi::op::custom<double, mpi::absmax<double>>(true)));
+
+        using compensated = mpi::compensated<double>;
+        std::vector<compensated> cx(n), cy(n);
+        std::transform(x.begin(), x.end(), cx.begin(), [](double v) { return compensated{v, 0.0}; });
+        report<compensated>("sum     compensated kernel    ", n,
+                            time_allreduce(cx, cy, mpi::op::custom<compensated, mpi::compensated_sum<double>>(true)));
+
+        using c32 = std::complex<float>;
+        std::vector<c32> zx(n), zy(n);
+        std::transform(x.begin(), x.end(), zx.begin(), [](double v) { return c32(v, -v); });
+        report<c32>("c32 sum builtin MPI_SUM       ", n, time_allreduce(zx, zy, MPI_SUM));
+        report<c32>("c32 absmax block kernel       ", n,
+                    time_allreduce(zx, zy, mpi::op::custom<c32, mpi::absmax<c32>>(true)));
+
+        struct double_int
+        {
+            double value;
+            int index;
+        };
+        std::vector<double_int> lx(n), ly(n);
+        using value_index = mpi::value_index<double>;
+        std::vector<value_index> vx(n), vy(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            lx[i] = {x[i], world.rank()};
+            vx[i] = {x[i], world.rank()};
+        }
+        world.barrier();
+        double start = MPI_Wtime();
+        for (int i = 0; i < 10; ++i)
+        {
+            MPI_Allreduce(lx.data(), ly.data(), n, MPI_DOUBLE_INT, MPI_MAXLOC, MPI_COMM_WORLD);
+        }
+        report<double_int>("maxloc  builtin MPI_MAXLOC    ", n, (MPI_Wtime() - start) / 10);
+        report<value_index>("maxloc  max_with_index kernel ", n,
+                            time_allreduce(vx, vy, mpi::op::custom<value_index, mpi::max_with_index<double>>(true)));
+    }
+
+    MPI_Op_free(&legacy_sum);
+    MPI_Op_free(&legacy_absmax);
+    return 0;
+}
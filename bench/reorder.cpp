@@ -0,0 +1,66 @@
+// Rank reordering from a recorded communication matrix: rank r exchanges heavily with rank r + p/2 and lightly with
+// its neighbours, so the default placement of consecutive ranks per node sends the heavy traffic between nodes.
+// mpirun -np 8 bench_reorder [ranks_per_node] [iterations]
+// ranks_per_node 0 takes the nodes from MPI (all ranks on one node in a single-machine run).
+#include <cstdlib>
+#include <mpi.hpp>
+#include <vector>
+
+// one step of the pattern on `comm`, rank r plays task r
+double exchange_time(const mpi::communicator &comm, int iterations)
+{
+    const int p = comm.size(), r = comm.rank();
+    const int partner = (r + p / 2) % p, right = (r + 1) % p, left = (r + p - 1) % p;
+    std::vector<double> heavy_out(1 << 16, 1.0), heavy_in(heavy_out.size()), light_out(64, 1.0), light_in(64);
+    comm.barrier();
+    double start = MPI_Wtime();
+    for (int i = 0; i < iterations; ++i)
+    {
+        std::vector<mpi::request> requests;
+        requests.push_back(comm.irecv(heavy_in.data(), heavy_in.size(), partner, 0));
+        requests.push_back(comm.irecv(light_in.data(), light_in.size(), left, 1));
+        requests.push_back(comm.isend(heavy_out.data(), heavy_out.size(), partner, 0));
+        requests.push_back(comm.isend(light_out.data(), light_out.size(), right, 1));
+        mpi::wait_all(requests);
+    }
+    double local = (MPI_Wtime() - start) / iterations, slowest;
+    comm.allreduce(local, slowest, mpi::op::max());
+    return slowest;
+}
+
+int main(int argc, char *argv[])
+{
+    mpi::environment env(argc, argv);
+    mpi::log_init(mpi::LogLevel::Info);
+
+    using mpi::world;
+
+    int ranks_per_node = argc > 1 ? std::atoi(argv[1]) : 2;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 100;
+    if (world.size() < 4 || world.size() % 2 != 0)
+    {
+        if (world.rank() == 0)
+            mpi::log_error("needs an even number of at least 4 ranks");
+        return 1;
+    }
+
+    double before = exchange_time(world, iterations);
+    for (bool use_mpi : {true, false})
+    {
+        mpi::communication_matrix recorded(world);
+        exchange_time(world, 3); // the warm-up the matrix records
+        double start = MPI_Wtime();
+        auto placed = mpi::reorder_ranks(recorded, {use_mpi, true, ranks_per_node});
+        double setup = MPI_Wtime() - start;
+        double after = exchange_time(placed.comm, iterations);
+        if (world.rank() == 0)
+        {
+            mpi::log_info(use_mpi ? "mpi + greedy" : "greedy only", ": method ", mpi::to_string(placed.method),
+                          ", inter-node bytes ", placed.inter_node_bytes_before, " -> ", placed.inter_node_bytes_after,
+                          " of ", placed.total_bytes, ", setup ", setup * 1e3, " ms, step ", before * 1e6, " -> ",
+                          after * 1e6, " us");
+        }
+        placed.comm.free();
+    }
+    return 0;
+}
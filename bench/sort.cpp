@@ -0,0 +1,51 @@
+// Sample sort scaling benchmark.
+// weak scaling:   mpirun -np P bench_sort weak   <keys per rank>
+// strong scaling: mpirun -np P bench_sort strong <total keys>
+#include <algorithm>
+#include <cstdlib>
+#include <mpi.hpp>
+#include <random>
+#include <string>
+
+int main(int argc, char *argv[])
+{
+    mpi::environment env(argc, argv);
+    mpi::log_init(mpi::LogLevel::Info);
+
+    using mpi::world;
+
+    std::string mode = argc > 1 ? argv[1] : "weak";
+    std::size_t n = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : (1 << 22);
+    const int repeat = 5;
+
+    std::size_t local_n = mode == "strong" ? mpi::block_partition(n, world.size()).size(world.rank()) : n;
+    std::mt19937_64 rng(12345 + world.rank());
+    std::uniform_int_distribution<long long> dist;
+    std::vector<long long> origin(local_n);
+    std::generate(origin.begin(), origin.end(), [&]() { return dist(rng); });
+
+    for (bool rebalance : {false, true})
+    {
+        double best = 1e300;
+        std::size_t max_local = 0;
+        for (int i = 0; i < repeat; ++i)
+        {
+            std::vector<long long> keys = origin;
+            world.barrier();
+            double start = MPI_Wtime();
+            mpi::sort(world, keys, std::less<long long>{}, rebalance);
+            double elapsed = MPI_Wtime() - start, slowest;
+            world.allreduce(elapsed, slowest, mpi::op::max());
+            best = std::min(best, slowest);
+            std::size_t local = keys.size();
+            world.allreduce(local, max_local, mpi::op::max());
+        }
+        if (world.rank() == 0)
+        {
+            std::size_t total = mode == "strong" ? n : n * world.size();
+            mpi::log_info(mode, " scaling, ranks = ", world.size(), ", keys = ", total, ", rebalance = ", rebalance,
+                          ", time = ", best, " s, rate = ", total / best / 1e6, " Mkeys/s, max local = ", max_local);
+        }
+    }
+    return 0;
+}
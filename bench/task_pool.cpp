@@ -0,0 +1,76 @@
+// Irregular workload: task costs grow with the rank, so a static partition leaves low ranks idle.
+// mpirun -np P bench_task_pool [tasks per rank] [mean task microseconds]
+#include <chrono>
+#include <cstdlib>
+#include <mpi.hpp>
+#include <random>
+#include <vector>
+
+struct work
+{
+    double microseconds;
+};
+
+void spin(double microseconds)
+{
+    double end = MPI_Wtime() + microseconds * 1e-6;
+    while (MPI_Wtime() < end)
+    {
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    mpi::environment env(argc, argv);
+    mpi::log_init(mpi::LogLevel::Info);
+
+    using mpi::world;
+
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000;
+    double mean = argc > 2 ? std::atof(argv[2]) : 100.0;
+    std::mt19937 rng(world.rank());
+    std::exponential_distribution<double> cost(1.0 / (mean * 2.0 * (world.rank() + 1) / world.size()));
+    std::vector<work> tasks(n);
+    for (auto &t : tasks)
+    {
+        t.microseconds = cost(rng);
+    }
+
+    auto report = [&](const char *name, double elapsed) {
+        double slowest, fastest;
+        world.allreduce(elapsed, slowest, mpi::op::max());
+        world.allreduce(elapsed, fastest, mpi::op::min());
+        if (world.rank() == 0)
+            mpi::log_info(name, ": time = ", slowest, " s, fastest rank finished its share after ", fastest, " s");
+    };
+
+    world.barrier();
+    double start = MPI_Wtime();
+    for (auto &t : tasks)
+    {
+        spin(t.microseconds);
+    }
+    report("static partition", MPI_Wtime() - start);
+
+    mpi::task_pool<work> pool(world, [](work &t, mpi::task_pool<work> &) { spin(t.microseconds); });
+    for (auto &t : tasks)
+    {
+        pool.push(t);
+    }
+    world.barrier();
+    start = MPI_Wtime();
+    pool.run();
+    double elapsed = MPI_Wtime() - start;
+    report("work stealing   ", elapsed);
+
+    const auto &stats = pool.stats();
+    std::size_t local[4] = {stats.tasks_executed, stats.steal_attempts, stats.steal_successes, stats.tasks_stolen};
+    std::size_t total[4];
+    world.reduce(local, total, 4, mpi::op::sum(), 0);
+    if (world.rank() == 0)
+    {
+        mpi::log_info("executed = ", total[0], ", steal attempts = ", total[1], ", successes = ", total[2],
+                      ", tasks stolen = ", total[3]);
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+// Multi-threaded message rate: T threads per rank exchange small messages with the same thread on the partner rank
+// (rank ^ 1), once over the shared world with one tag per thread and once over per-thread communicators.
+// mpirun -np 2 bench_threads [threads] [messages per thread] [bytes]
+#include <cstdlib>
+#include <mpi.hpp>
+#include <thread>
+#include <vector>
+
+// window of non-blocking sends and receives, like the OSU multi-threaded message rate test
+constexpr int window = 64;
+
+void exchange(const mpi::communicator &comm, int peer, int tag, std::size_t messages, std::size_t bytes)
+{
+    std::vector<char> out(bytes * window), in(bytes * window);
+    std::vector<mpi::request> reqs;
+    reqs.reserve(2 * window);
+    for (std::size_t sent = 0; sent < messages; sent += window)
+    {
+        for (int i = 0; i < window; ++i)
+        {
+            reqs.push_back(comm.irecv(in.data() + i * bytes, bytes, peer, tag));
+        }
+        for (int i = 0; i < window; ++i)
+        {
+            reqs.push_back(comm.isend(out.data() + i * bytes, bytes, peer, tag));
+        }
+        mpi::wait_all(reqs);
+        reqs.clear();
+    }
+}
+
+template <typename F>
+double timed(int threads, F body)
+{
+    mpi::world.barrier();
+    double start = MPI_Wtime();
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t)
+    {
+        pool.emplace_back(body, t);
+    }
+    for (auto &th : pool)
+    {
+        th.join();
+    }
+    double elapsed = MPI_Wtime() - start, slowest;
+    mpi::world.allreduce(elapsed, slowest, mpi::op::max());
+    return slowest;
+}
+
+int main(int argc, char *argv[])
+{
+    mpi::environment env(argc, argv, mpi::thread_level::multiple);
+    mpi::log_init(mpi::LogLevel::Info);
+
+    using mpi::world;
+
+    int threads = argc > 1 ? std::atoi(argv[1]) : 4;
+    std::size_t messages = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 20000;
+    std::size_t bytes = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 8;
+    if (env.provided() != mpi::thread_level::multiple || world.size() % 2 != 0)
+    {
+        if (world.rank() == 0)
+            mpi::log_error("needs MPI_THREAD_MULTIPLE and an even number of ranks, provided ",
+                           mpi::to_string(env.provided()));
+        return 1;
+    }
+    const int peer = world.rank() ^ 1;
+    const double total = double(messages) * threads * world.size(); // messages sent by all ranks
+
+    double shared = timed(threads, [&](int t) { exchange(world, peer, t, messages, bytes); });
+
+    mpi::thread_communicators comms(world, threads);
+    double separate = timed(threads, [&](int t) { exchange(comms[t], peer, 0, messages, bytes); });
+
+    if (world.rank() == 0)
+    {
+        mpi::log_info(threads, " threads, ", bytes, " bytes, ", mpi::to_string(env.provided()));
+        mpi::log_info("shared world      : ", total / shared / 1e6, " Mmsg/s");
+        mpi::log_info("per-thread comms  : ", total / separate / 1e6, " Mmsg/s");
+    }
+    return 0;
+}
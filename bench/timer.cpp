@@ -0,0 +1,56 @@
+// Cost of entering and leaving a scoped_timer, and the report of a deliberately imbalanced workload.
+// mpirun -np 4 bench_timer [iterations]
+#include <cmath>
+#include <cstdlib>
+#include <mpi.hpp>
+
+double work(std::size_t n)
+{
+    double sum = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        sum += std::sqrt(static_cast<double>(i));
+    }
+    return sum;
+}
+
+int main(int argc, char *argv[])
+{
+    mpi::environment env(argc, argv);
+    mpi::log_init(mpi::LogLevel::Info);
+
+    using mpi::world;
+
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+    double start = MPI_Wtime();
+    for (int i = 0; i < iterations; ++i)
+    {
+        mpi::scoped_timer outer("outer");
+        mpi::scoped_timer inner("inner");
+    }
+    double overhead = (MPI_Wtime() - start) / (2 * iterations);
+    mpi::timer_registry::instance().reset();
+    if (world.rank() == 0)
+        mpi::log_info("scoped_timer enter + leave: ", overhead * 1e9, " ns");
+
+    // rank r computes (r + 1) times as much, the exchange waits for the slowest
+    double checksum = 0;
+    for (int step = 0; step < 10; ++step)
+    {
+        mpi::scoped_timer t("step");
+        {
+            mpi::scoped_timer c("compute");
+            checksum += work(std::size_t(200000) * (world.rank() + 1));
+        }
+        {
+            mpi::scoped_timer x("exchange");
+            double total;
+            world.allreduce(checksum, total, mpi::op::sum());
+        }
+    }
+    mpi::log_timers();
+    if (mpi::write_timers_json("bench_timer.json") && world.rank() == 0)
+        mpi::log_info("report written to bench_timer.json");
+    return 0;
+}
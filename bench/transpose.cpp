@@ -0,0 +1,68 @@
+// Slab and pencil transposes of an n^3 complex<double> array, as in a distributed 3-D FFT, with both redistribution
+// methods. Bandwidth counts the whole array once per transpose.
+// mpirun -np P bench_transpose [n] [repetitions]
+#include <complex>
+#include <cstdlib>
+#include <mpi.hpp>
+#include <vector>
+
+using value_type = std::complex<double>;
+
+template <std::size_t N>
+void run(const char *name, const std::vector<mpi::box<N>> &from, const std::vector<mpi::box<N>> &to, int repetitions,
+         double bytes)
+{
+    using mpi::world;
+    auto automatic = mpi::redistribution_plan<value_type, N>(world, from, to).method();
+    for (auto method : {mpi::redistribution_method::alltoallw, mpi::redistribution_method::packed})
+    {
+        mpi::redistribution_plan<value_type, N> plan(world, from, to, method);
+        std::vector<value_type> src(plan.source_size(), value_type(world.rank(), 1.0)), dst(plan.target_size());
+        plan.execute(src.data(), dst.data());
+        world.barrier();
+        double start = MPI_Wtime();
+        for (int i = 0; i < repetitions; ++i)
+        {
+            plan.execute(src.data(), dst.data());
+        }
+        double elapsed = (MPI_Wtime() - start) / repetitions, slowest;
+        world.allreduce(elapsed, slowest, mpi::op::max());
+        if (world.rank() == 0)
+        {
+            bool packed = method == mpi::redistribution_method::packed;
+            mpi::log_info(name, packed ? " packed alltoallv: " : " alltoallw       : ", slowest * 1e3, " ms, ",
+                          bytes / slowest / 1e9, " GB/s", method == automatic ? " (automatic choice)" : "");
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    mpi::environment env(argc, argv);
+    mpi::log_init(mpi::LogLevel::Info);
+
+    using mpi::world;
+
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 128;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 10;
+    const std::array<std::size_t, 3> shape{n, n, n};
+    const double bytes = double(n) * n * n * sizeof(value_type);
+    const int p = world.size();
+
+    // x-slabs to y-slabs
+    run("slab  ", mpi::slab_decomposition(shape, p, 0), mpi::slab_decomposition(shape, p, 1), repetitions, bytes);
+
+    // z-pencils (x and y split) to y-pencils (x and z split) on the squarest process grid
+    int rows = 1;
+    for (int r = 1; r * r <= p; ++r)
+    {
+        if (p % r == 0)
+            rows = r;
+    }
+    const std::array<int, 2> grid{rows, p / rows};
+    run("pencil", mpi::pencil_decomposition(shape, grid, {0, 1}), mpi::pencil_decomposition(shape, grid, {0, 2}),
+        repetitions, bytes);
+    if (world.rank() == 0)
+        mpi::log_info(n, "^3 complex<double>, ", p, " ranks, pencil grid ", grid[0], " x ", grid[1]);
+    return 0;
+}
@@ -0,0 +1,54 @@
+// Tunes allreduce and alltoall for this communicator size, prints (and optionally saves) the table, then compares the
+// library collectives with the tuned dispatch. Run later jobs with MPICPP_TUNING_FILE=<file> to load the table.
+// mpirun -np P bench_tuned [tuning file to write]
+#include <mpi.hpp>
+#include <vector>
+
+int main(int argc, char *argv[])
+{
+    mpi::environment env(argc, argv);
+    mpi::log_init(mpi::LogLevel::Info);
+
+    using mpi::world;
+
+    mpi::tune_collectives(world);
+    auto &table = mpi::tuning_table::global();
+    if (world.rank() == 0)
+    {
+        mpi::log_info("tuning table:\n", table.str());
+        if (argc > 1)
+            mpi::log_info(table.save(argv[1]) ? "saved to " : "could not write ", argv[1]);
+    }
+
+    auto timed = [&](auto run) {
+        run();
+        world.barrier();
+        double start = MPI_Wtime();
+        const int repetitions = 20;
+        for (int i = 0; i < repetitions; ++i)
+        {
+            run();
+        }
+        double elapsed = (MPI_Wtime() - start) / repetitions, slowest;
+        world.allreduce(elapsed, slowest, mpi::op::max());
+        return slowest;
+    };
+    const int p = world.size();
+    for (std::size_t bytes : {std::size_t(8), std::size_t(4096), std::size_t(1) << 20})
+    {
+        std::size_t count = bytes / sizeof(double);
+        std::vector<double> send(count * p, 1.0), recv(count * p);
+        double lib_allreduce = timed([&]() { world.allreduce(send.data(), recv.data(), count, mpi::op::sum()); });
+        double tuned_allreduce =
+            timed([&]() { mpi::tuned_allreduce(world, send.data(), recv.data(), count, mpi::op::sum()); });
+        double lib_alltoall = timed([&]() { world.alltoall(send.data(), int(count), recv.data(), int(count)); });
+        double tuned_alltoall = timed([&]() { mpi::tuned_alltoall(world, send.data(), recv.data(), count); });
+        if (world.rank() == 0)
+        {
+            mpi::log_info(bytes, " bytes: allreduce ", lib_allreduce * 1e6, " us -> ", tuned_allreduce * 1e6, " us (",
+                          mpi::to_string(table.allreduce(p, bytes)), "), alltoall ", lib_alltoall * 1e6, " us -> ",
+                          tuned_alltoall * 1e6, " us (", mpi::to_string(table.alltoall(p, bytes)), ")");
+        }
+    }
+    return 0;
+}
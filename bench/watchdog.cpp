@@ -0,0 +1,64 @@
+// Ping-pong latency with operation tracking (bench_watchdog, built with MPICPP_WATCHDOG) and without
+// (bench_watchdog_off), and the completion latency histograms of the tracked run.
+// mpirun -np 2 bench_watchdog [iterations]
+#include <cstdlib>
+#include <mpi.hpp>
+#include <vector>
+
+double pingpong_time(std::size_t n, int iterations, bool nonblocking)
+{
+    const auto &world = mpi::world;
+    std::vector<char> data(n);
+    int peer = 1 - world.rank();
+    world.barrier();
+    double start = MPI_Wtime();
+    for (int i = 0; i < iterations; ++i)
+    {
+        if (nonblocking)
+        {
+            auto received = world.irecv(data.data(), n, peer, 0);
+            auto sent = world.isend(data.data(), n, peer, 0);
+            received.wait();
+            sent.wait();
+        }
+        else if (world.rank() == 0)
+        {
+            world.send(data.data(), n, peer, 0);
+            world.recv(data.data(), n, peer, 0);
+        }
+        else
+        {
+            world.recv(data.data(), n, peer, 0);
+            world.send(data.data(), n, peer, 0);
+        }
+    }
+    return (MPI_Wtime() - start) / (nonblocking ? iterations : 2 * iterations);
+}
+
+int main(int argc, char *argv[])
+{
+    mpi::environment env(argc, argv);
+    mpi::log_init(mpi::LogLevel::Info);
+
+    using mpi::world;
+
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 20000;
+    if (world.size() != 2)
+    {
+        if (world.rank() == 0)
+            mpi::log_error("needs 2 ranks");
+        return 1;
+    }
+
+    for (std::size_t n : {std::size_t(8), std::size_t(1) << 16})
+    {
+        double blocking = pingpong_time(n, iterations, false);
+        double nonblocking = pingpong_time(n, iterations, true);
+        if (world.rank() == 0)
+            mpi::log_info(mpi::tracking_enabled ? "tracked " : "untracked ", n, " bytes: send/recv ", blocking * 1e6,
+                          " us, isend/irecv ", nonblocking * 1e6, " us");
+    }
+    if (mpi::tracking_enabled)
+        mpi::log_latency_histograms();
+    return 0;
+}
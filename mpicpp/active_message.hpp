@@ -0,0 +1,266 @@
+#pragma once
+#ifndef MPI_ACTIVE_MESSAGE_HPP
+#define MPI_ACTIVE_MESSAGE_HPP
+
+#include "communicator.hpp"
+#include "memory.hpp"
+#include "request.hpp"
+#include "serialize.hpp"
+#include "status.hpp"
+#include "types.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace mpi
+{
+
+class active_messages;
+
+template <typename Signature>
+struct am_handler;
+
+// returned by active_messages::register_handler, names a handler on every rank (registration order must match).
+template <typename R, typename... Args>
+struct am_handler<R(Args...)>
+{
+    int id;
+};
+
+// The reply of active_messages::call. get() drives the progress loop until the reply has arrived.
+template <typename R>
+class am_future
+{
+  public:
+    using value_type = std::conditional_t<std::is_void_v<R>, std::monostate, R>;
+
+  private:
+    std::shared_ptr<std::optional<value_type>> m_state;
+    active_messages *m_am;
+
+  public:
+    am_future(std::shared_ptr<std::optional<value_type>> state, active_messages *am)
+        : m_state(std::move(state)), m_am(am)
+    {
+    }
+    bool ready() const { return m_state->has_value(); }
+    void wait();
+    R get()
+    {
+        wait();
+        if constexpr (!std::is_void_v<R>)
+            return std::move(**m_state);
+    }
+};
+
+// Active messages: a handler registered on every rank is invoked on a remote rank with serialized arguments,
+// optionally sending its result back. Messages travel on a duplicate of the given communicator, so they cannot
+// match application messages. Handlers run inside progress(), which drains arrived messages with MPI_Improbe and
+// MPI_Imrecv; handlers may send further messages.
+class active_messages
+{
+  private:
+    enum class kind : std::uint8_t
+    {
+        oneway,
+        request,
+        reply
+    };
+    struct header
+    {
+        std::int32_t handler;
+        kind type;
+        std::uint64_t call;
+    };
+    struct in_flight
+    {
+        std::vector<std::byte> data;
+        request req;
+    };
+    using dispatcher = std::function<void(int source, deserializer &in, std::uint64_t call)>;
+
+    static constexpr int tag = 1;
+
+    communicator m_comm;
+    std::vector<dispatcher> m_handlers;
+    std::unordered_map<std::uint64_t, std::function<void(deserializer &)>> m_replies;
+    std::uint64_t m_next_call = 1;
+    std::vector<in_flight> m_sending;
+    // messages (including replies) sent and handled by this rank, for termination detection
+    long long m_sent = 0;
+    long long m_received = 0;
+
+  public:
+    // collective over `comm`
+    explicit active_messages(const communicator &comm) : m_comm(comm.dup()) {}
+    active_messages(const active_messages &) = delete;
+    active_messages &operator=(const active_messages &) = delete;
+    ~active_messages()
+    {
+        m_sending.clear();
+        m_comm.free();
+    }
+
+    const communicator &comm() const { return m_comm; }
+
+    // `f` is any callable with a fixed signature; arguments and result must be serializable.
+    template <typename F>
+    auto register_handler(F f)
+    {
+        return register_function(std::function{std::move(f)});
+    }
+
+    // fire and forget
+    template <typename R, typename... Args, typename... Ts>
+    void invoke(am_handler<R(Args...)> handler, int dest, Ts &&...args)
+    {
+        static_assert(sizeof...(Args) == sizeof...(Ts), "wrong number of arguments");
+        serializer out;
+        out << header{handler.id, kind::oneway, 0};
+        if constexpr (sizeof...(Args) > 0)
+            (out << ... << std::decay_t<Args>(std::forward<Ts>(args)));
+        send(dest, out.take());
+    }
+
+    // invoke and get the result back
+    template <typename R, typename... Args, typename... Ts>
+    am_future<R> call(am_handler<R(Args...)> handler, int dest, Ts &&...args)
+    {
+        static_assert(sizeof...(Args) == sizeof...(Ts), "wrong number of arguments");
+        using value_type = typename am_future<R>::value_type;
+        auto state = std::make_shared<std::optional<value_type>>();
+        std::uint64_t id = m_next_call++;
+        m_replies.emplace(id, [state](deserializer &in) {
+            if constexpr (std::is_void_v<R>)
+                state->emplace();
+            else
+                state->emplace(in.get<R>());
+        });
+        serializer out;
+        out << header{handler.id, kind::request, id};
+        if constexpr (sizeof...(Args) > 0)
+            (out << ... << std::decay_t<Args>(std::forward<Ts>(args)));
+        send(dest, out.take());
+        return am_future<R>(std::move(state), this);
+    }
+
+    // handle every message which has arrived, returns whether there was any.
+    bool progress()
+    {
+        bool handled = false;
+        MPI_Message msg;
+        status st;
+        while (m_comm.improbe(MPI_ANY_SOURCE, tag, msg, st))
+        {
+            buffer<std::byte> message(st.get_count<std::byte>());
+            m_comm.imrecv(message.data(), message.size(), msg).wait();
+            deserializer in(message.data(), message.size());
+            dispatch(st.source(), in);
+            handled = true;
+        }
+        for (std::size_t i = 0; i < m_sending.size();)
+        {
+            if (m_sending[i].req.test())
+            {
+                m_sending[i] = std::move(m_sending.back());
+                m_sending.pop_back();
+            }
+            else
+            {
+                ++i;
+            }
+        }
+        return handled;
+    }
+
+    // Collective termination detection: keeps handling messages until no rank has messages in flight and no handler
+    // is running anywhere. Uses the four-counter method: non-blocking allreduces of the sent/handled counts, overlapped
+    // with progress, until two consecutive waves see equal and unchanged totals.
+    void quiesce()
+    {
+        long long previous[2] = {-1, -1};
+        while (true)
+        {
+            long long local[2] = {m_sent, m_received}, global[2];
+            request wave = m_comm.iallreduce(local, global, 2, op::sum());
+            while (!wave.test())
+            {
+                progress();
+            }
+            if (global[0] == global[1] && global[0] == previous[0] && global[1] == previous[1])
+                break;
+            previous[0] = global[0];
+            previous[1] = global[1];
+            progress();
+        }
+    }
+
+  private:
+    template <typename R, typename... Args>
+    am_handler<R(Args...)> register_function(std::function<R(Args...)> f)
+    {
+        int id = static_cast<int>(m_handlers.size());
+        m_handlers.push_back([this, f = std::move(f)](int source, deserializer &in, std::uint64_t call) {
+            std::tuple<std::decay_t<Args>...> args;
+            if constexpr (sizeof...(Args) > 0)
+                std::apply([&in](auto &...items) { (in >> ... >> items); }, args);
+            if (call == 0)
+            {
+                std::apply(f, std::move(args));
+                return;
+            }
+            serializer out;
+            out << header{0, kind::reply, call};
+            if constexpr (std::is_void_v<R>)
+                std::apply(f, std::move(args));
+            else
+                out << std::apply(f, std::move(args));
+            send(source, out.take());
+        });
+        return am_handler<R(Args...)>{id};
+    }
+
+    void send(int dest, std::vector<std::byte> data)
+    {
+        const std::byte *ptr = data.data();
+        std::size_t size = data.size();
+        m_sending.push_back(in_flight{std::move(data), m_comm.isend(ptr, size, dest, tag)});
+        ++m_sent;
+    }
+
+    void dispatch(int source, deserializer &in)
+    {
+        header h;
+        in >> h;
+        ++m_received;
+        if (h.type == kind::reply)
+        {
+            auto it = m_replies.find(h.call);
+            it->second(in);
+            m_replies.erase(it);
+        }
+        else
+        {
+            m_handlers[h.handler](source, in, h.type == kind::request ? h.call : 0);
+        }
+    }
+};
+
+template <typename R>
+void am_future<R>::wait()
+{
+    while (!ready())
+    {
+        m_am->progress();
+    }
+}
+
+} // end namespace mpi
+
+#endif // MPI_ACTIVE_MESSAGE_HPP
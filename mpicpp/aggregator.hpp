@@ -0,0 +1,203 @@
+#pragma once
+#ifndef MPI_AGGREGATOR_HPP
+#define MPI_AGGREGATOR_HPP
+
+#include "communicator.hpp"
+#include "request.hpp"
+#include "status.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+namespace mpi
+{
+
+inline constexpr int aggregator_tag = 32766;
+
+// When a destination buffer is shipped: when it holds `max_records` records, or when all buffers together exceed
+// `max_buffered_bytes` (then every buffer is shipped), or on an explicit flush().
+struct flush_policy
+{
+    std::size_t max_records = 4096;
+    std::size_t max_buffered_bytes = std::size_t(64) << 20;
+};
+
+// Buffers small records per destination rank and ships each buffer as one message. Received batches are handed to
+// `handler(source, records, count)` from poll() and finish(), and also while pushing, so the peers' batches keep
+// draining. Records are sent as raw bytes, T must be trivially copyable. A push to the own rank calls the handler
+// at flush time without going through MPI. Handlers may push() except while finish() runs.
+template <typename T>
+class aggregator
+{
+    static_assert(std::is_trivially_copyable_v<T>, "aggregator<T> needs a trivially copyable T");
+
+  public:
+    using handler_type = std::function<void(int source, const T *records, std::size_t count)>;
+
+    struct statistics
+    {
+        std::size_t records_pushed = 0;
+        std::size_t batches_sent = 0;
+        std::size_t batches_received = 0;
+        std::size_t records_received = 0;
+    };
+
+  private:
+    struct in_flight
+    {
+        std::vector<T> data;
+        request req;
+    };
+
+    communicator m_comm;
+    handler_type m_handler;
+    flush_policy m_policy;
+    int m_tag;
+    std::vector<std::vector<T>> m_buffers;
+    std::size_t m_buffered_bytes = 0;
+    std::vector<in_flight> m_sending;
+    std::vector<std::vector<T>> m_spare;
+    // batches sent to and received from each rank since the last finish()
+    std::vector<std::size_t> m_batches_to;
+    std::vector<std::size_t> m_batches_from;
+    bool m_finishing = false;
+    statistics m_stats;
+
+  public:
+    aggregator(const communicator &comm, handler_type handler, flush_policy policy = {}, int tag = aggregator_tag)
+        : m_comm(comm), m_handler(std::move(handler)), m_policy(policy), m_tag(tag), m_buffers(comm.size()),
+          m_batches_to(comm.size(), 0), m_batches_from(comm.size(), 0)
+    {
+    }
+    aggregator(const aggregator &) = delete;
+    aggregator &operator=(const aggregator &) = delete;
+
+    const statistics &stats() const { return m_stats; }
+
+    void push(int dest, const T &record)
+    {
+        assert(!m_finishing && "aggregator: a handler must not push during finish()");
+        auto &buf = m_buffers[dest];
+        buf.push_back(record);
+        m_buffered_bytes += sizeof(T);
+        ++m_stats.records_pushed;
+        if (buf.size() >= m_policy.max_records)
+        {
+            ship(dest);
+        }
+        else if (m_buffered_bytes >= m_policy.max_buffered_bytes)
+        {
+            flush();
+        }
+    }
+
+    // ship every non-empty buffer
+    void flush()
+    {
+        for (int dest = 0; dest < static_cast<int>(m_buffers.size()); ++dest)
+        {
+            if (!m_buffers[dest].empty())
+                ship(dest);
+        }
+    }
+
+    // deliver the batches which have arrived and recycle the buffers of completed sends
+    void poll()
+    {
+        status st;
+        while (m_comm.iprobe(MPI_ANY_SOURCE, m_tag, st))
+        {
+            receive(st);
+        }
+        for (std::size_t i = 0; i < m_sending.size();)
+        {
+            if (m_sending[i].req.test())
+            {
+                recycle(std::move(m_sending[i].data));
+                m_sending[i] = std::move(m_sending.back());
+                m_sending.pop_back();
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+    // Collective: flush, then deliver every batch the other ranks sent to this one before their finish(). The batch
+    // counts are exchanged with one alltoall. The batches of each source arrive in order, so receiving from each
+    // source until its count is reached never mistakes a batch of a peer's next round for one of this round.
+    void finish()
+    {
+        m_finishing = true;
+        flush();
+        std::vector<std::size_t> expected(m_comm.size());
+        m_comm.alltoall(m_batches_to.data(), expected.data());
+        for (int src = 0; src < m_comm.size(); ++src)
+        {
+            while (m_batches_from[src] < expected[src])
+            {
+                receive(m_comm.probe(src, m_tag));
+            }
+            m_batches_from[src] -= expected[src];
+        }
+        m_sending.clear(); // waits for the remaining sends
+        std::fill(m_batches_to.begin(), m_batches_to.end(), 0);
+        m_finishing = false;
+    }
+
+  private:
+    void ship(int dest)
+    {
+        std::vector<T> batch = take_spare();
+        batch.swap(m_buffers[dest]);
+        m_buffered_bytes -= batch.size() * sizeof(T);
+        if (dest == m_comm.rank())
+        {
+            m_handler(dest, batch.data(), batch.size());
+            recycle(std::move(batch));
+            return;
+        }
+        ++m_batches_to[dest];
+        ++m_stats.batches_sent;
+        const std::byte *bytes = reinterpret_cast<const std::byte *>(batch.data());
+        std::size_t size = batch.size() * sizeof(T);
+        m_sending.push_back(in_flight{std::move(batch), m_comm.isend(bytes, size, dest, m_tag)});
+        poll();
+    }
+
+    void receive(status st)
+    {
+        std::size_t count = st.get_count<std::byte>() / sizeof(T);
+        std::vector<T> batch = take_spare();
+        batch.resize(count);
+        m_comm.recv(reinterpret_cast<std::byte *>(batch.data()), count * sizeof(T), st.source(), m_tag);
+        ++m_batches_from[st.source()];
+        ++m_stats.batches_received;
+        m_stats.records_received += count;
+        m_handler(st.source(), batch.data(), count);
+        recycle(std::move(batch));
+    }
+
+    std::vector<T> take_spare()
+    {
+        if (m_spare.empty())
+            return {};
+        std::vector<T> v = std::move(m_spare.back());
+        m_spare.pop_back();
+        return v;
+    }
+
+    void recycle(std::vector<T> v)
+    {
+        v.clear();
+        m_spare.push_back(std::move(v));
+    }
+};
+
+} // end namespace mpi
+
+#endif // MPI_AGGREGATOR_HPP
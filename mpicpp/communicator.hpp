@@ -3,10 +3,15 @@
 #define MPI_BASE_HPP
 
 #include "environment.hpp"
+#include "memory.hpp"
 #include "request.hpp"
 #include "status.hpp"
+#include "traffic.hpp"
 #include "types.hpp"
-#include <mutex>
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <ranges>
 #include <stdexcept>
 #include <vector>
 
@@ -40,22 +45,61 @@ class communicator
 #endif
 
     communicator(MPI_Comm comm) : m_comm(comm) {}
+    MPI_Comm data() const { return m_comm; }
+    bool is_null() const { return m_comm == MPI_COMM_NULL; }
+    // a new communicator with the same group and its own message space, to be released with free().
+    communicator dup() const
+    {
+        MPI_Comm comm;
+        check(MPI_Comm_dup(m_comm, &comm));
+        detail::record_traffic_dup(m_comm, comm);
+        return communicator{comm};
+    }
+    // collective: the ranks of the same `color` form a new communicator, ordered by `key` (ties by rank)
+    communicator split(int color, int key) const
+    {
+        MPI_Comm comm;
+        check(MPI_Comm_split(m_comm, color, key, &comm));
+        return communicator{comm};
+    }
+    // collective: the ranks which can share memory, usually the ranks of one node
+    communicator split_shared(int key = 0) const
+    {
+        MPI_Comm comm;
+        check(MPI_Comm_split_type(m_comm, MPI_COMM_TYPE_SHARED, key, MPI_INFO_NULL, &comm));
+        return communicator{comm};
+    }
+    void free()
+    {
+        if (is_null())
+            return;
+        check(MPI_Comm_free(&m_comm));
+    }
+    // not cached: a function-local static would be shared by every communicator.
     int rank() const
     {
-        static thread_local int local_rank = -1;
-        static std::once_flag flag;
-        std::call_once(flag, [this]() { check(MPI_Comm_rank(m_comm, &local_rank)); });
+        int local_rank;
+        check(MPI_Comm_rank(m_comm, &local_rank));
         return local_rank;
     }
     int size() const
     {
-        static thread_local int local_size = -1;
-        static std::once_flag flag;
-        std::call_once(flag, [this]() { check(MPI_Comm_size(m_comm, &local_size)); });
+        int local_size;
+        check(MPI_Comm_size(m_comm, &local_size));
         return local_size;
     }
 
-    void barrier() { check(MPI_Barrier(m_comm)); }
+    void barrier() const
+    {
+        detail::watch_blocking watch(operation::barrier, -1, 0, 0);
+        check(MPI_Barrier(m_comm));
+    }
+    request ibarrier() const
+    {
+        MPI_Request req;
+        check(MPI_Ibarrier(m_comm, &req));
+        return request{req};
+    }
     void abort(int errorcode) const { MPI_Abort(m_comm, errorcode); }
 
     // ----- broadcast -----
@@ -64,17 +108,18 @@ class communicator
     void broadcast(T *buf, std::size_t count, int root) const
     {
         check_type<T>();
-        check(MPI_Bcast(buf, count, mpi_type<T>(), root, m_comm));
+        detail::large_count n(count, mpi_type<T>());
+        check(MPICPP_COUNTED(MPI_Bcast)(buf, n.count(), n.type(), root, m_comm));
     }
 
-    template <typename T>
+    template <single_element T>
     void broadcast(T &buf, int root) const
     {
         broadcast<T>(&buf, 1, root);
     }
 
-    template <typename T>
-    void broadcast(std::vector<T> &data, int root) const
+    template <typename T, typename Alloc>
+    void broadcast(std::vector<T, Alloc> &data, int root) const
     {
         std::size_t size;
         if (rank() == root)
@@ -84,7 +129,7 @@ class communicator
         broadcast<std::size_t>(size, root);
         if (rank() != root)
         {
-            data.resize(size);
+            detail::resize_for_overwrite(data, size);
         }
         broadcast<T>(data.data(), data.size(), root);
     }
@@ -99,7 +144,7 @@ class communicator
         broadcast<std::size_t>(size, root);
         if (rank() != root)
         {
-            str.resize(size);
+            detail::resize_for_overwrite(str, size);
         }
         broadcast<char>(str.data(), str.size(), root);
     }
@@ -110,17 +155,20 @@ class communicator
     void send(const T *buf, std::size_t count, int dest, int tag) const
     {
         check_type<T>();
-        check(MPI_Send(buf, count, mpi_type<T>(), dest, tag, m_comm));
+        detail::watch_blocking watch(operation::send, dest, tag, count * sizeof(T));
+        detail::record_traffic(m_comm, dest, count * sizeof(T));
+        detail::large_count n(count, mpi_type<T>());
+        check(MPICPP_COUNTED(MPI_Send)(buf, n.count(), n.type(), dest, tag, m_comm));
     }
 
-    template <typename T>
+    template <single_element T>
     void send(const T buf, int dest, int tag) const
     {
         send<T>(&buf, 1, dest, tag);
     }
 
-    template <typename T>
-    void send(const std::vector<T> &data, int dest, int tag) const
+    template <typename T, typename Alloc>
+    void send(const std::vector<T, Alloc> &data, int dest, int tag) const
     {
         send<std::size_t>(data.size(), dest, tag);
         send<T>(data.data(), data.size(), dest, tag);
@@ -138,21 +186,23 @@ class communicator
     void recv(T *buf, std::size_t count, int src, int tag) const
     {
         check_type<T>();
-        check(MPI_Recv(buf, count, mpi_type<T>(), src, tag, m_comm, MPI_STATUS_IGNORE));
+        detail::watch_blocking watch(operation::recv, src, tag, count * sizeof(T));
+        detail::large_count n(count, mpi_type<T>());
+        check(MPICPP_COUNTED(MPI_Recv)(buf, n.count(), n.type(), src, tag, m_comm, MPI_STATUS_IGNORE));
     }
 
-    template <typename T>
+    template <single_element T>
     void recv(T &buf, int src, int tag) const
     {
         return recv<T>(&buf, 1, src, tag);
     }
 
-    template <typename T>
-    void recv(std::vector<T> &data, int src, int tag) const
+    template <typename T, typename Alloc>
+    void recv(std::vector<T, Alloc> &data, int src, int tag) const
     {
         std::size_t size;
         recv<std::size_t>(size, src, tag);
-        data.resize(size);
+        detail::resize_for_overwrite(data, size);
         recv<T>(data.data(), data.size(), src, tag);
     }
 
@@ -160,7 +210,7 @@ class communicator
     {
         std::size_t size;
         recv<std::size_t>(size, src, tag);
-        str.resize(size);
+        detail::resize_for_overwrite(str, size);
         recv<char>(str.data(), str.size(), src, tag);
     }
 
@@ -168,21 +218,23 @@ class communicator
     void recv(T *buf, std::size_t count, int src, int tag, status &st) const
     {
         check_type<T>();
-        check(MPI_Recv(buf, count, mpi_type<T>(), src, tag, m_comm, st.ptr()));
+        detail::watch_blocking watch(operation::recv, src, tag, count * sizeof(T));
+        detail::large_count n(count, mpi_type<T>());
+        check(MPICPP_COUNTED(MPI_Recv)(buf, n.count(), n.type(), src, tag, m_comm, st.ptr()));
     }
 
-    template <typename T>
+    template <single_element T>
     void recv(T &buf, int src, int tag, status &st) const
     {
         recv<T>(&buf, 1, src, tag, st);
     }
 
-    template <typename T>
-    void recv(std::vector<T> &data, int src, int tag, status &st) const
+    template <typename T, typename Alloc>
+    void recv(std::vector<T, Alloc> &data, int src, int tag, status &st) const
     {
         std::size_t size;
         recv<std::size_t>(size, src, tag, st);
-        data.resize(size);
+        detail::resize_for_overwrite(data, size);
         recv<T>(data.data(), data.size(), src, tag, st);
     }
 
@@ -190,7 +242,7 @@ class communicator
     {
         std::size_t size;
         recv<std::size_t>(size, src, tag, st);
-        str.resize(size);
+        detail::resize_for_overwrite(str, size);
         recv<char>(str.data(), str.size(), src, tag, st);
     }
 
@@ -201,16 +253,34 @@ class communicator
     {
         check_type<T>();
         MPI_Request req;
-        check(MPI_Isend(buf, count, mpi_type<T>(), dest, tag, m_comm, &req));
+        detail::large_count n(count, mpi_type<T>());
+        check(MPICPP_COUNTED(MPI_Isend)(buf, n.count(), n.type(), dest, tag, m_comm, &req));
+        detail::watch_started(req, operation::isend, dest, tag, count * sizeof(T));
+        detail::record_traffic(m_comm, dest, count * sizeof(T));
         return request{req};
     }
 
-    template <typename T>
+    template <single_element T>
     request isend(const T buf, int dest, int tag) const
     {
         return isend<T>(&buf, 1, dest, tag);
     }
 
+    // ----- issend -----
+
+    // completes only once the matching receive has started
+    template <typename T>
+    request issend(const T *buf, std::size_t count, int dest, int tag) const
+    {
+        check_type<T>();
+        MPI_Request req;
+        detail::large_count n(count, mpi_type<T>());
+        check(MPICPP_COUNTED(MPI_Issend)(buf, n.count(), n.type(), dest, tag, m_comm, &req));
+        detail::watch_started(req, operation::isend, dest, tag, count * sizeof(T));
+        detail::record_traffic(m_comm, dest, count * sizeof(T));
+        return request{req};
+    }
+
     // ----- irecv -----
 
     template <typename T>
@@ -218,34 +288,96 @@ class communicator
     {
         check_type<T>();
         MPI_Request req;
-        check(MPI_Irecv(buf, count, mpi_type<T>(), src, tag, m_comm, &req));
+        detail::large_count n(count, mpi_type<T>());
+        check(MPICPP_COUNTED(MPI_Irecv)(buf, n.count(), n.type(), src, tag, m_comm, &req));
+        detail::watch_started(req, operation::irecv, src, tag, count * sizeof(T));
         return request{req};
     }
 
-    template <typename T>
+    template <single_element T>
     request irecv(T &buf, int src, int tag) const
     {
         return irecv<T>(&buf, 1, src, tag);
     }
 
+    // ----- sendrecv -----
+
+    template <typename T>
+    void sendrecv(const T *send_data, std::size_t send_count, int dest, int send_tag, T *recv_data,
+                  std::size_t recv_count, int src, int recv_tag) const
+    {
+        check_type<T>();
+        detail::watch_blocking watch(operation::sendrecv, src, recv_tag, (send_count + recv_count) * sizeof(T));
+        detail::record_traffic(m_comm, dest, send_count * sizeof(T));
+        detail::large_count s(send_count, mpi_type<T>()), r(recv_count, mpi_type<T>());
+        check(MPICPP_COUNTED(MPI_Sendrecv)(send_data, s.count(), s.type(), dest, send_tag, recv_data, r.count(),
+                                           r.type(), src, recv_tag, m_comm, MPI_STATUS_IGNORE));
+    }
+
+    // ----- probe -----
+
+    status probe(int src, int tag) const
+    {
+        status st;
+        detail::watch_blocking watch(operation::probe, src, tag, 0);
+        check(MPI_Probe(src, tag, m_comm, st.ptr()));
+        return st;
+    }
+
+    bool iprobe(int src, int tag, status &st) const
+    {
+        int flag;
+        check(MPI_Iprobe(src, tag, m_comm, &flag, st.ptr()));
+        return flag;
+    }
+
+    // matched probe: the message can then only be received through `msg`, even by another thread.
+    bool improbe(int src, int tag, MPI_Message &msg, status &st) const
+    {
+        int flag;
+        check(MPI_Improbe(src, tag, m_comm, &flag, &msg, st.ptr()));
+        return flag;
+    }
+
+    // blocking matched probe, see improbe
+    status mprobe(int src, int tag, MPI_Message &msg) const
+    {
+        status st;
+        detail::watch_blocking watch(operation::probe, src, tag, 0);
+        check(MPI_Mprobe(src, tag, m_comm, &msg, st.ptr()));
+        return st;
+    }
+
+    template <typename T>
+    request imrecv(T *buf, std::size_t count, MPI_Message &msg) const
+    {
+        check_type<T>();
+        MPI_Request req;
+        detail::large_count n(count, mpi_type<T>());
+        check(MPICPP_COUNTED(MPI_Imrecv)(buf, n.count(), n.type(), &msg, &req));
+        return request{req};
+    }
+
     // ----- scatter -----
 
     template <typename T>
-    void scatter(const T *send_data, T *recv_data, std::size_t count, int root)
+    void scatter(const T *send_data, T *recv_data, std::size_t count, int root) const
     {
         check_type<T>();
-        MPI_Scatter(send_data, count, mpi_type<T>(), recv_data, count, mpi_type, root, m_comm);
+        detail::large_count n(count, mpi_type<T>());
+        check(MPICPP_COUNTED(MPI_Scatter)(send_data, n.count(), n.type(), recv_data, n.count(), n.type(), root,
+                                          m_comm));
     }
 
     template <typename T>
-    void scatter(const T *send_data, T &recv_data, int root)
+    void scatter(const T *send_data, T &recv_data, int root) const
     {
         scatter<T>(send_data, &recv_data, 1, root);
     }
 
     // for non-root process, send_data is not needed.
     template <typename T>
-    void scatter(T &recv_data, int root)
+    void scatter(T &recv_data, int root) const
     {
         scatter<T>(nullptr, &recv_data, 1, root);
     }
@@ -253,21 +385,22 @@ class communicator
     // ----- gather -----
 
     template <typename T>
-    void gather(const T *send_data, T *recv_data, std::size_t count, int root)
+    void gather(const T *send_data, T *recv_data, std::size_t count, int root) const
     {
         check_type<T>();
-        MPI_Gather(send_data, count, mpi_type<T>(), recv_data, count, mpi_type<T>(), root, m_comm);
+        detail::large_count n(count, mpi_type<T>());
+        check(MPICPP_COUNTED(MPI_Gather)(send_data, n.count(), n.type(), recv_data, n.count(), n.type(), root, m_comm));
     }
 
     template <typename T>
-    void gather(const T send_data, T *recv_data, int root)
+    void gather(const T send_data, T *recv_data, int root) const
     {
         gather<T>(&send_data, recv_data, 1, root);
     }
 
     // for non-root process, recv_data is not needed.
     template <typename T>
-    void gather(const T send_data, int root)
+    void gather(const T send_data, int root) const
     {
         gather<T>(&send_data, nullptr, 1, root);
     }
@@ -275,59 +408,162 @@ class communicator
     // ----- allgather -----
 
     template <typename T>
-    void allgather(const T *send_data, T *recv_data, std::size_t count)
+    void allgather(const T *send_data, T *recv_data, std::size_t count) const
     {
         check_type<T>();
-        MPI_Allgather(send_data, count, mpi_type<T>(), recv_data, count, mpi_type, m_comm);
+        detail::large_count n(count, mpi_type<T>());
+        check(MPICPP_COUNTED(MPI_Allgather)(send_data, n.count(), n.type(), recv_data, n.count(), n.type(), m_comm));
     }
 
     template <typename T>
-    void allgather(const T send_data, T *recv_data)
+    void allgather(const T send_data, T *recv_data) const
     {
         allgather<T>(&send_data, recv_data, 1);
     }
 
-    // ----- reduce -----
+    // ----- allgatherv -----
 
+    // the counts are ints as in MPI_Allgatherv, `send_count` is one of them.
     template <typename T>
-    void reduce(const T *send_data, T *recv_data, std::size_t count, MPI_Op op, int root)
+    void allgatherv(const T *send_data, std::size_t send_count, T *recv_data, const int *recv_counts,
+                    const int *displs) const
     {
         check_type<T>();
-        ;
-        MPI_Reduce(send_data, recv_data, count, mpi_type<T>(), op, root, m_comm);
+        assert(send_count <= static_cast<std::size_t>(std::numeric_limits<int>::max()) &&
+               "allgatherv: send_count does not fit in an int");
+        check(MPI_Allgatherv(send_data, static_cast<int>(send_count), mpi_type<T>(), recv_data, recv_counts, displs,
+                             mpi_type<T>(), m_comm));
     }
 
+    // ----- reduce -----
+
     template <typename T>
-    void reduce(const T send_data, T &recv_data, MPI_Op op, int root)
+    void reduce(const T *send_data, T *recv_data, std::size_t count, MPI_Op op, int root) const
+    {
+        check_type<T>();
+        // derived datatypes do not work with predefined ops, large counts are reduced in chunks.
+        detail::for_each_chunk(count, [&](std::size_t offset, detail::count_type n) {
+            check(MPICPP_COUNTED(MPI_Reduce)(detail::chunk(send_data, offset), detail::chunk(recv_data, offset), n,
+                                             mpi_type<T>(), op, root, m_comm));
+        });
+    }
+
+    template <single_element T>
+    void reduce(const T send_data, T &recv_data, MPI_Op op, int root) const
     {
         reduce<T>(&send_data, &recv_data, 1, op, root);
     }
 
-    template <typename T>
-    void reduce(const T send_data, MPI_Op op, int root)
+    template <single_element T>
+    void reduce(const T send_data, MPI_Op op, int root) const
     {
         reduce<T>(&send_data, nullptr, 1, op, root);
     }
 
+    // reductions with a functor, see functor_op. Pass commute = true only for a commutative functor.
+    template <typename T, reduction_functor<T> Func>
+    void reduce(const T *send_data, T *recv_data, std::size_t count, Func func, int root, bool commute = false) const
+    {
+        reduce<T>(send_data, recv_data, count, functor_op<T, Func>(std::move(func), commute).get(), root);
+    }
+
+    template <typename T, reduction_functor<T> Func>
+    void reduce(const T send_data, T &recv_data, Func func, int root, bool commute = false) const
+    {
+        reduce<T>(&send_data, &recv_data, 1, functor_op<T, Func>(std::move(func), commute).get(), root);
+    }
+
+    template <typename T, reduction_functor<T> Func>
+    void reduce(const T send_data, Func func, int root, bool commute = false) const
+    {
+        reduce<T>(&send_data, nullptr, 1, functor_op<T, Func>(std::move(func), commute).get(), root);
+    }
+
     // ----- allreduce -----
 
     template <typename T>
-    void allreduce(const T *send_data, T *recv_data, std::size_t count, MPI_Op op)
+    void allreduce(const T *send_data, T *recv_data, std::size_t count, MPI_Op op) const
     {
         check_type<T>();
-        MPI_Allreduce(send_data, recv_data, count, mpi_type<T>(), op, m_comm);
+        detail::for_each_chunk(count, [&](std::size_t offset, detail::count_type n) {
+            check(MPICPP_COUNTED(MPI_Allreduce)(detail::chunk(send_data, offset), detail::chunk(recv_data, offset), n,
+                                                mpi_type<T>(), op, m_comm));
+        });
     }
 
-    template <typename T>
-    void allreduce(const T send_data, T &recv_data, MPI_Op op)
+    template <single_element T>
+    void allreduce(const T send_data, T &recv_data, MPI_Op op) const
     {
         allreduce<T>(&send_data, &recv_data, 1, op);
     }
 
+    template <typename T, reduction_functor<T> Func>
+    void allreduce(const T *send_data, T *recv_data, std::size_t count, Func func, bool commute = false) const
+    {
+        allreduce<T>(send_data, recv_data, count, functor_op<T, Func>(std::move(func), commute).get());
+    }
+
+    template <typename T, reduction_functor<T> Func>
+    void allreduce(const T send_data, T &recv_data, Func func, bool commute = false) const
+    {
+        allreduce<T>(&send_data, &recv_data, 1, functor_op<T, Func>(std::move(func), commute).get());
+    }
+
+    // ----- iallreduce -----
+
+    template <typename T>
+    request iallreduce(const T *send_data, T *recv_data, std::size_t count, MPI_Op op) const
+    {
+        check_type<T>();
+        MPI_Request req;
+        // a single request cannot be split into chunks
+        assert(count <= detail::large_count::max_count && "iallreduce: count too large for this MPI");
+        check(MPICPP_COUNTED(MPI_Iallreduce)(send_data, recv_data, static_cast<detail::count_type>(count),
+                                             mpi_type<T>(), op, m_comm, &req));
+        return request{req};
+    }
+
+    // ----- scan -----
+
+    template <typename T>
+    void scan(const T *send_data, T *recv_data, std::size_t count, MPI_Op op) const
+    {
+        check_type<T>();
+        detail::for_each_chunk(count, [&](std::size_t offset, detail::count_type n) {
+            check(MPICPP_COUNTED(MPI_Scan)(detail::chunk(send_data, offset), detail::chunk(recv_data, offset), n,
+                                           mpi_type<T>(), op, m_comm));
+        });
+    }
+
+    template <typename T>
+    void scan(const T send_data, T &recv_data, MPI_Op op) const
+    {
+        scan<T>(&send_data, &recv_data, 1, op);
+    }
+
+    // ----- exscan -----
+
+    // recv_data on rank 0 is left unchanged.
+    template <typename T>
+    void exscan(const T *send_data, T *recv_data, std::size_t count, MPI_Op op) const
+    {
+        check_type<T>();
+        detail::for_each_chunk(count, [&](std::size_t offset, detail::count_type n) {
+            check(MPICPP_COUNTED(MPI_Exscan)(detail::chunk(send_data, offset), detail::chunk(recv_data, offset), n,
+                                             mpi_type<T>(), op, m_comm));
+        });
+    }
+
+    template <typename T>
+    void exscan(const T send_data, T &recv_data, MPI_Op op) const
+    {
+        exscan<T>(&send_data, &recv_data, 1, op);
+    }
+
     // ----- alltoall -----
 
     template <typename T>
-    void alltoall(const T *send_data, int send_count, T *recv_data, int recv_count)
+    void alltoall(const T *send_data, int send_count, T *recv_data, int recv_count) const
     {
         check_type<T>();
         MPI_Alltoall(send_data, send_count, mpi_type<T>(), recv_data, recv_count, mpi_type<T>(), m_comm);
@@ -335,12 +571,163 @@ class communicator
 
     // 只发送一个的情况
     template <typename T>
-    void alltoall(const T *send_data, T *recv_data)
+    void alltoall(const T *send_data, T *recv_data) const
     {
         check_type<T>();
         MPI_Alltoall(send_data, 1, mpi_type<T>(), recv_data, 1, mpi_type<T>(), m_comm);
     }
 
+    // ----- alltoallv -----
+
+    template <typename T>
+    void alltoallv(const T *send_data, const int *send_counts, const int *send_displs, T *recv_data,
+                   const int *recv_counts, const int *recv_displs) const
+    {
+        check_type<T>();
+        check(MPI_Alltoallv(send_data, send_counts, send_displs, mpi_type<T>(), recv_data, recv_counts, recv_displs,
+                            mpi_type<T>(), m_comm));
+    }
+
+    // ----- alltoallw -----
+
+    // a datatype per rank, the displacements are in bytes.
+    void alltoallw(const void *send_data, const int *send_counts, const int *send_displs,
+                   const MPI_Datatype *send_types, void *recv_data, const int *recv_counts, const int *recv_displs,
+                   const MPI_Datatype *recv_types) const
+    {
+        check(MPI_Alltoallw(send_data, send_counts, send_displs, send_types, recv_data, recv_counts, recv_displs,
+                            recv_types, m_comm));
+    }
+
+    // ----- contiguous ranges -----
+
+    // Any contiguous range (std::array, std::span, a sub-range of a vector...) is sent in place. Unlike the
+    // std::vector and std::string overloads no size travels with it: the receiving range must have room for the
+    // whole message.
+
+    template <contiguous_buffer R>
+    void broadcast(R &&data, int root) const
+    {
+        broadcast<std::ranges::range_value_t<R>>(std::ranges::data(data), std::ranges::size(data), root);
+    }
+
+    template <contiguous_buffer R>
+    void send(const R &data, int dest, int tag) const
+    {
+        send(std::ranges::data(data), std::ranges::size(data), dest, tag);
+    }
+
+    template <contiguous_buffer R>
+    void recv(R &&data, int src, int tag) const
+    {
+        recv<std::ranges::range_value_t<R>>(std::ranges::data(data), std::ranges::size(data), src, tag);
+    }
+
+    template <contiguous_buffer R>
+    void recv(R &&data, int src, int tag, status &st) const
+    {
+        recv<std::ranges::range_value_t<R>>(std::ranges::data(data), std::ranges::size(data), src, tag, st);
+    }
+
+    // the range must stay alive until the request has completed
+    template <contiguous_buffer R>
+    request isend(const R &data, int dest, int tag) const
+    {
+        return isend(std::ranges::data(data), std::ranges::size(data), dest, tag);
+    }
+
+    template <contiguous_buffer R>
+    request irecv(R &&data, int src, int tag) const
+    {
+        return irecv<std::ranges::range_value_t<R>>(std::ranges::data(data), std::ranges::size(data), src, tag);
+    }
+
+    // `recv_data` is only used on the root.
+    template <contiguous_buffer R1, contiguous_buffer R2>
+    void reduce(const R1 &send_data, R2 &&recv_data, MPI_Op op, int root) const
+    {
+        assert(rank() != root || std::ranges::size(recv_data) == std::ranges::size(send_data));
+        reduce(std::ranges::data(send_data), std::ranges::data(recv_data), std::ranges::size(send_data), op, root);
+    }
+
+    template <contiguous_buffer R1, contiguous_buffer R2>
+    void allreduce(const R1 &send_data, R2 &&recv_data, MPI_Op op) const
+    {
+        assert(std::ranges::size(recv_data) == std::ranges::size(send_data));
+        allreduce(std::ranges::data(send_data), std::ranges::data(recv_data), std::ranges::size(send_data), op);
+    }
+
+    // `recv_data` holds size() times `send_data`.
+    template <contiguous_buffer R1, contiguous_buffer R2>
+    void allgather(const R1 &send_data, R2 &&recv_data) const
+    {
+        assert(std::ranges::size(recv_data) == std::ranges::size(send_data) * size());
+        allgather(std::ranges::data(send_data), std::ranges::data(recv_data), std::ranges::size(send_data));
+    }
+
+    // both ranges hold size() equal blocks.
+    template <contiguous_buffer R1, contiguous_buffer R2>
+    void alltoall(const R1 &send_data, R2 &&recv_data) const
+    {
+        assert(std::ranges::size(recv_data) == std::ranges::size(send_data));
+        assert(std::ranges::size(send_data) % size() == 0 && "alltoall: range size is not a multiple of size()");
+        int count = static_cast<int>(std::ranges::size(send_data) / size());
+        alltoall(std::ranges::data(send_data), count, std::ranges::data(recv_data), count);
+    }
+
+    // ----- datatype views -----
+
+    // Non-contiguous selections (strided_view, subarray_view) go to MPI as one element of their derived datatype,
+    // so MPI gathers and scatters the elements without a packing copy on our side.
+
+    template <datatype_view V>
+    void broadcast(const V &view, int root) const
+    {
+        check(MPI_Bcast(view.data(), 1, view.type(), root, m_comm));
+    }
+
+    template <datatype_view V>
+    void send(const V &view, int dest, int tag) const
+    {
+        detail::watch_blocking watch(operation::send, dest, tag, detail::tracked_bytes(view.type()));
+        detail::record_traffic(m_comm, dest, view.type(), 1);
+        check(MPI_Send(view.data(), 1, view.type(), dest, tag, m_comm));
+    }
+
+    template <datatype_view V>
+    void recv(const V &view, int src, int tag) const
+    {
+        detail::watch_blocking watch(operation::recv, src, tag, detail::tracked_bytes(view.type()));
+        check(MPI_Recv(view.data(), 1, view.type(), src, tag, m_comm, MPI_STATUS_IGNORE));
+    }
+
+    template <datatype_view V>
+    void recv(const V &view, int src, int tag, status &st) const
+    {
+        detail::watch_blocking watch(operation::recv, src, tag, detail::tracked_bytes(view.type()));
+        check(MPI_Recv(view.data(), 1, view.type(), src, tag, m_comm, st.ptr()));
+    }
+
+    // the view (and its datatype) must stay alive until the request has completed
+    template <datatype_view V>
+    request isend(const V &view, int dest, int tag) const
+    {
+        MPI_Request req;
+        check(MPI_Isend(view.data(), 1, view.type(), dest, tag, m_comm, &req));
+        detail::watch_started(req, operation::isend, dest, tag, detail::tracked_bytes(view.type()));
+        detail::record_traffic(m_comm, dest, view.type(), 1);
+        return request{req};
+    }
+
+    template <datatype_view V>
+    request irecv(const V &view, int src, int tag) const
+    {
+        MPI_Request req;
+        check(MPI_Irecv(view.data(), 1, view.type(), src, tag, m_comm, &req));
+        detail::watch_started(req, operation::irecv, src, tag, detail::tracked_bytes(view.type()));
+        return request{req};
+    }
+
   private:
     MPI_Comm m_comm;
 };
@@ -0,0 +1,301 @@
+#pragma once
+#ifndef MPI_COMPRESS_HPP
+#define MPI_COMPRESS_HPP
+
+#include "communicator.hpp"
+#include "memory.hpp"
+#include "status.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace mpi
+{
+
+// Lossless compression for large arrays on a bandwidth-bound network. The codec XORs every value with the one before
+// (for 4- and 8-byte types), so neighbouring values of smooth data leave mostly zero sign, exponent and high mantissa
+// bits; shuffles the bytes into planes (all first bytes, all second bytes...), which gathers those zeros into long
+// runs; and stores the planes as literal bytes and zero-run lengths. Random data does not compress and travels raw
+// with a one byte header. No dependencies, one pass over the data each way.
+
+struct compression_options
+{
+    // messages of fewer bytes are sent as they are, sender and receiver must agree on it
+    std::size_t threshold_bytes = std::size_t(64) << 10;
+};
+
+namespace detail
+{
+
+inline constexpr std::size_t min_zero_run = 8;
+
+inline void put_varint(buffer<std::byte> &out, std::size_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<std::byte>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<std::byte>(value));
+}
+
+inline bool get_varint(const std::byte *&in, const std::byte *end, std::size_t &value)
+{
+    value = 0;
+    for (int shift = 0; in < end && shift < 64; shift += 7)
+    {
+        auto byte = static_cast<std::uint8_t>(*in++);
+        value |= static_cast<std::size_t>(byte & 0x7f) << shift;
+        if (byte < 0x80)
+            return true;
+    }
+    return false;
+}
+
+// the number of zero bytes at the start of [data, data + size)
+inline std::size_t zero_run(const std::uint8_t *data, std::size_t size)
+{
+    std::size_t run = 0;
+    for (std::uint64_t word; run + 8 <= size; run += 8)
+    {
+        std::memcpy(&word, data + run, 8);
+        if (word != 0)
+            break;
+    }
+    while (run < size && data[run] == 0)
+    {
+        ++run;
+    }
+    return run;
+}
+
+template <typename T>
+using delta_word = std::conditional_t<sizeof(T) == 8, std::uint64_t, std::uint32_t>;
+template <typename T>
+inline constexpr bool xor_delta = sizeof(T) == 8 || sizeof(T) == 4;
+
+} // end namespace detail
+
+// Appends the encoding of `count` values to `out`.
+template <typename T>
+void compress(const T *data, std::size_t count, buffer<std::byte> &out)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "compress needs a trivially copyable T");
+    constexpr std::size_t width = sizeof(T);
+    const std::size_t bytes = count * width;
+    buffer<std::byte> planes(bytes);
+    const auto *raw = reinterpret_cast<const std::uint8_t *>(data);
+    auto *plane = reinterpret_cast<std::uint8_t *>(planes.data());
+    if constexpr (detail::xor_delta<T>)
+    {
+        using word = detail::delta_word<T>;
+        word previous = 0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            word w;
+            std::memcpy(&w, raw + i * width, width);
+            word delta = w ^ previous;
+            previous = w;
+            for (std::size_t b = 0; b < width; ++b)
+            {
+                plane[b * count + i] = static_cast<std::uint8_t>(delta >> (8 * b));
+            }
+        }
+    }
+    else
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            for (std::size_t b = 0; b < width; ++b)
+            {
+                plane[b * count + i] = raw[i * width + b];
+            }
+        }
+    }
+
+    // tokens: literal length, literals, zero-run length
+    std::size_t pos = 0;
+    while (pos < bytes)
+    {
+        std::size_t literal_end = pos, run = 0;
+        while (literal_end < bytes)
+        {
+            // memchr skips the non-zero bytes quickly, then the run is measured a word at a time
+            const void *zero = std::memchr(plane + literal_end, 0, bytes - literal_end);
+            if (!zero)
+            {
+                literal_end = bytes;
+                break;
+            }
+            literal_end = static_cast<const std::uint8_t *>(zero) - plane;
+            run = detail::zero_run(plane + literal_end, bytes - literal_end);
+            if (run >= detail::min_zero_run || literal_end + run == bytes)
+                break;
+            literal_end += run;
+            run = 0;
+        }
+        detail::put_varint(out, literal_end - pos);
+        out.insert(out.end(), planes.begin() + pos, planes.begin() + literal_end);
+        detail::put_varint(out, run);
+        pos = literal_end + run;
+    }
+}
+
+// Decodes exactly `count` values, false if `in` is not a valid encoding of them.
+template <typename T>
+bool decompress(const std::byte *in, std::size_t size, T *data, std::size_t count)
+{
+    constexpr std::size_t width = sizeof(T);
+    const std::size_t bytes = count * width;
+    buffer<std::byte> planes(bytes);
+    const std::byte *end = in + size;
+    std::size_t pos = 0;
+    while (pos < bytes)
+    {
+        std::size_t literals, run;
+        if (!detail::get_varint(in, end, literals) || literals > static_cast<std::size_t>(end - in) ||
+            pos + literals > bytes)
+            return false;
+        std::memcpy(planes.data() + pos, in, literals);
+        in += literals;
+        pos += literals;
+        if (!detail::get_varint(in, end, run) || pos + run > bytes)
+            return false;
+        std::memset(planes.data() + pos, 0, run);
+        pos += run;
+    }
+    const auto *plane = reinterpret_cast<const std::uint8_t *>(planes.data());
+    auto *raw = reinterpret_cast<std::uint8_t *>(data);
+    if constexpr (detail::xor_delta<T>)
+    {
+        using word = detail::delta_word<T>;
+        word previous = 0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            word delta = 0;
+            for (std::size_t b = 0; b < width; ++b)
+            {
+                delta |= static_cast<word>(plane[b * count + i]) << (8 * b);
+            }
+            previous ^= delta;
+            std::memcpy(raw + i * width, &previous, width);
+        }
+    }
+    else
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            for (std::size_t b = 0; b < width; ++b)
+            {
+                raw[i * width + b] = plane[b * count + i];
+            }
+        }
+    }
+    return in == end;
+}
+
+namespace detail
+{
+
+enum class encoding : std::uint8_t
+{
+    raw,
+    compressed
+};
+
+// header byte + payload, the payload raw when compression does not pay off
+template <typename T>
+buffer<std::byte> encode_message(const T *data, std::size_t count)
+{
+    buffer<std::byte> message;
+    message.reserve(count * sizeof(T) + 16);
+    message.push_back(static_cast<std::byte>(encoding::compressed));
+    compress(data, count, message);
+    if (message.size() > count * sizeof(T))
+    {
+        message.resize(1 + count * sizeof(T));
+        message[0] = static_cast<std::byte>(encoding::raw);
+        std::memcpy(message.data() + 1, data, count * sizeof(T));
+    }
+    return message;
+}
+
+template <typename T>
+bool decode_message(const std::byte *message, std::size_t size, T *data, std::size_t count)
+{
+    if (size == 0)
+        return false;
+    if (static_cast<encoding>(message[0]) == encoding::raw)
+    {
+        if (size != 1 + count * sizeof(T))
+            return false;
+        std::memcpy(data, message + 1, count * sizeof(T));
+        return true;
+    }
+    return decompress(message + 1, size - 1, data, count);
+}
+
+} // end namespace detail
+
+// ----- transport -----
+
+// Like communicator::send, compressed when the array is at least options.threshold_bytes.
+template <typename T>
+void compressed_send(const communicator &comm, const T *data, std::size_t count, int dest, int tag,
+                     compression_options options = {})
+{
+    if (count * sizeof(T) < options.threshold_bytes)
+    {
+        comm.send(data, count, dest, tag);
+        return;
+    }
+    auto message = detail::encode_message(data, count);
+    comm.send(message.data(), message.size(), dest, tag);
+}
+
+// Receives `count` values sent with compressed_send and the same threshold, returns false (leaving `data` undefined)
+// for a corrupt message or a count mismatch. The matched probe keeps other threads from taking the message.
+template <typename T>
+bool compressed_recv(const communicator &comm, T *data, std::size_t count, int src, int tag,
+                     compression_options options = {})
+{
+    if (count * sizeof(T) < options.threshold_bytes)
+    {
+        comm.recv(data, count, src, tag);
+        return true;
+    }
+    MPI_Message msg;
+    status st = comm.mprobe(src, tag, msg);
+    buffer<std::byte> message(st.get_count_x<std::byte>());
+    comm.imrecv(message.data(), message.size(), msg).wait();
+    return detail::decode_message(message.data(), message.size(), data, count);
+}
+
+// Like communicator::broadcast, compressed when the array is at least options.threshold_bytes. Returns false on a
+// rank which got a corrupt message, as compressed_recv.
+template <typename T>
+bool compressed_broadcast(const communicator &comm, T *data, std::size_t count, int root,
+                          compression_options options = {})
+{
+    if (count * sizeof(T) < options.threshold_bytes)
+    {
+        comm.broadcast(data, count, root);
+        return true;
+    }
+    buffer<std::byte> message;
+    if (comm.rank() == root)
+        message = detail::encode_message(data, count);
+    std::size_t size = message.size();
+    comm.broadcast(size, root);
+    message.resize(size);
+    comm.broadcast(message.data(), size, root);
+    if (comm.rank() == root)
+        return true;
+    return detail::decode_message(message.data(), message.size(), data, count);
+}
+
+} // end namespace mpi
+
+#endif // MPI_COMPRESS_HPP
@@ -0,0 +1,169 @@
+#pragma once
+#ifndef MPI_DISTRIBUTED_VECTOR_HPP
+#define MPI_DISTRIBUTED_VECTOR_HPP
+
+#include "communicator.hpp"
+#include "partition.hpp"
+#include "types.hpp"
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+namespace mpi
+{
+
+// A vector whose elements are spread over the ranks of a communicator in rank order. Every rank owns one contiguous
+// block and knows the global offsets of all blocks, so index arithmetic needs no communication, and every algorithm
+// below costs a single collective call.
+// `identity` arguments must be neutral for the operation, they stand in for the contribution of empty blocks.
+template <typename T>
+class distributed_vector
+{
+  private:
+    communicator m_comm;
+    std::vector<std::size_t> m_offsets; // p + 1 global offsets
+    std::vector<T> m_local;
+
+    distributed_vector(const communicator &comm, std::vector<std::size_t> offsets, std::vector<T> local)
+        : m_comm(comm), m_offsets(std::move(offsets)), m_local(std::move(local))
+    {
+    }
+
+  public:
+    using value_type = T;
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    // `global_size` elements in the equal block partition, no communication.
+    distributed_vector(const communicator &comm, std::size_t global_size, const T &value = T{})
+        : m_comm(comm), m_offsets(block_partition(global_size, comm.size()).offsets())
+    {
+        m_local.assign(m_offsets[comm.rank() + 1] - m_offsets[comm.rank()], value);
+    }
+
+    // adopt the local blocks as they are, one allgather of the local sizes.
+    distributed_vector(const communicator &comm, std::vector<T> local) : m_comm(comm), m_local(std::move(local))
+    {
+        const int p = comm.size();
+        std::size_t n = m_local.size();
+        std::vector<std::size_t> sizes(p);
+        m_comm.allgather(n, sizes.data());
+        m_offsets.assign(p + 1, 0);
+        for (int r = 0; r < p; ++r)
+        {
+            m_offsets[r + 1] = m_offsets[r] + sizes[r];
+        }
+    }
+
+    const communicator &comm() const { return m_comm; }
+
+    // ----- partition and global index helpers -----
+
+    std::size_t size() const { return m_offsets.back(); }
+    std::size_t local_size() const { return m_local.size(); }
+    const std::vector<std::size_t> &offsets() const { return m_offsets; }
+    std::size_t local_begin() const { return m_offsets[m_comm.rank()]; }
+    std::size_t local_end() const { return m_offsets[m_comm.rank() + 1]; }
+    std::size_t local_begin(int rank) const { return m_offsets[rank]; }
+    std::size_t local_size(int rank) const { return m_offsets[rank + 1] - m_offsets[rank]; }
+    bool is_local(std::size_t global_index) const
+    {
+        return global_index >= local_begin() && global_index < local_end();
+    }
+    // the rank which holds `global_index`, O(log p)
+    int owner(std::size_t global_index) const
+    {
+        assert(global_index < size());
+        auto it = std::upper_bound(m_offsets.begin(), m_offsets.end(), global_index);
+        return static_cast<int>(it - m_offsets.begin()) - 1;
+    }
+    std::size_t to_local(std::size_t global_index) const { return global_index - local_begin(); }
+    std::size_t to_global(std::size_t local_index) const { return local_begin() + local_index; }
+
+    // ----- local block access -----
+
+    std::vector<T> &local() { return m_local; }
+    const std::vector<T> &local() const { return m_local; }
+    T &operator[](std::size_t local_index) { return m_local[local_index]; }
+    const T &operator[](std::size_t local_index) const { return m_local[local_index]; }
+    // access by global index, which must be local.
+    T &global(std::size_t global_index)
+    {
+        assert(is_local(global_index));
+        return m_local[to_local(global_index)];
+    }
+    const T &global(std::size_t global_index) const
+    {
+        assert(is_local(global_index));
+        return m_local[to_local(global_index)];
+    }
+    iterator begin() { return m_local.begin(); }
+    iterator end() { return m_local.end(); }
+    const_iterator begin() const { return m_local.begin(); }
+    const_iterator end() const { return m_local.end(); }
+
+    // ----- algorithms -----
+
+    // local reduction and one allreduce, the result is on every rank.
+    template <typename BinaryOp = std::plus<T>>
+    T reduce(T identity = T{}, BinaryOp binop = {}) const
+    {
+        return transform_reduce(identity, binop, [](const T &x) { return x; });
+    }
+
+    template <typename U, typename BinaryOp, typename UnaryOp>
+    U transform_reduce(U identity, BinaryOp binop, UnaryOp unop) const
+    {
+        U local = std::transform_reduce(m_local.begin(), m_local.end(), identity, binop, unop);
+        U result;
+        // std::transform_reduce already needs a commutative binop
+        m_comm.allreduce(local, result, binop, true);
+        return result;
+    }
+
+    // local scan and one exscan of the block totals.
+    template <typename BinaryOp = std::plus<T>>
+    distributed_vector inclusive_scan(BinaryOp binop = {}, T identity = T{}) const
+    {
+        std::vector<T> result(m_local.size());
+        T prefix = exclusive_prefix(binop, identity);
+        std::inclusive_scan(m_local.begin(), m_local.end(), result.begin(), binop, prefix);
+        return distributed_vector(m_comm, m_offsets, std::move(result));
+    }
+
+    template <typename BinaryOp = std::plus<T>>
+    distributed_vector exclusive_scan(T init, BinaryOp binop = {}, T identity = T{}) const
+    {
+        std::vector<T> result(m_local.size());
+        T prefix = binop(init, exclusive_prefix(binop, identity));
+        std::exclusive_scan(m_local.begin(), m_local.end(), result.begin(), prefix, binop);
+        return distributed_vector(m_comm, m_offsets, std::move(result));
+    }
+
+    // move to another layout given by p + 1 global offsets, one alltoallv.
+    void redistribute(const std::vector<std::size_t> &offsets)
+    {
+        mpi::redistribute(m_comm, m_local, m_offsets, offsets);
+        m_offsets = offsets;
+    }
+    void redistribute(const block_partition &target) { redistribute(target.offsets()); }
+    // back to the equal block partition
+    void rebalance() { redistribute(block_partition(size(), m_comm.size())); }
+
+  private:
+    // combination of all blocks before this rank, `identity` on rank 0.
+    template <typename BinaryOp>
+    T exclusive_prefix(BinaryOp binop, T identity) const
+    {
+        T total = std::accumulate(m_local.begin(), m_local.end(), identity, binop);
+        T prefix = identity;
+        m_comm.exscan(total, prefix, functor_op<T, BinaryOp>(binop, false).get());
+        return m_comm.rank() == 0 ? identity : prefix;
+    }
+};
+
+} // end namespace mpi
+
+#endif // MPI_DISTRIBUTED_VECTOR_HPP
@@ -3,15 +3,83 @@
 #define MPI_ENVIRONMENT_HPP
 
 #include "error.hpp"
+#include <functional>
+#include <vector>
 
 namespace mpi
 {
 
+// The thread support levels of MPI_Init_thread, in increasing order.
+enum class thread_level
+{
+    single = MPI_THREAD_SINGLE,         // only one thread
+    funneled = MPI_THREAD_FUNNELED,     // only the main thread calls MPI
+    serialized = MPI_THREAD_SERIALIZED, // any thread calls MPI, one at a time
+    multiple = MPI_THREAD_MULTIPLE      // any thread calls MPI at any time
+};
+
+inline const char *to_string(thread_level level)
+{
+    switch (level)
+    {
+        case thread_level::single: return "MPI_THREAD_SINGLE";
+        case thread_level::funneled: return "MPI_THREAD_FUNNELED";
+        case thread_level::serialized: return "MPI_THREAD_SERIALIZED";
+        case thread_level::multiple: return "MPI_THREAD_MULTIPLE";
+    }
+    return "unknown";
+}
+
+namespace detail
+{
+
+inline std::vector<std::function<void()>> &init_hooks()
+{
+    static std::vector<std::function<void()>> hooks;
+    return hooks;
+}
+
+} // end namespace detail
+
+// Run `hook` at the end of the environment constructor, once MPI is usable. Headers register their setup with it
+// from the initializer of an inline variable, so the return value is only there to initialize that variable.
+inline bool at_init(std::function<void()> hook)
+{
+    detail::init_hooks().push_back(std::move(hook));
+    return true;
+}
+
 class environment
 {
   public:
-    environment(int argc, char **argv) { CHECK_MPI(MPI_Init(&argc, &argv)); }
+    environment(int argc, char **argv)
+    {
+        CHECK_MPI(MPI_Init(&argc, &argv));
+        m_provided = query_thread_level();
+        run_init_hooks();
+    }
+    // MPI may provide a lower level than `required`, check provided() before calling MPI from other threads.
+    environment(int argc, char **argv, thread_level required)
+    {
+        int provided;
+        CHECK_MPI(MPI_Init_thread(&argc, &argv, static_cast<int>(required), &provided));
+        m_provided = static_cast<thread_level>(provided);
+        run_init_hooks();
+    }
     ~environment() { CHECK_MPI(MPI_Finalize()); }
+    thread_level provided() const { return m_provided; }
+    static thread_level query_thread_level()
+    {
+        int provided;
+        CHECK_MPI(MPI_Query_thread(&provided));
+        return static_cast<thread_level>(provided);
+    }
+    static bool is_thread_main()
+    {
+        int flag;
+        CHECK_MPI(MPI_Is_thread_main(&flag));
+        return flag;
+    }
     static bool initialized()
     {
         int flag;
@@ -24,8 +92,36 @@ class environment
         CHECK_MPI(MPI_Finalized(&flag));
         return flag;
     }
+
+  private:
+    thread_level m_provided;
+
+    static void run_init_hooks()
+    {
+        for (auto &hook : detail::init_hooks())
+        {
+            hook();
+        }
+    }
 };
 
+// Run `hook` at the beginning of MPI_Finalize, while MPI is still usable. Hooks run in reverse order of registration
+// (they are attributes of MPI_COMM_SELF, which MPI deletes first during finalize).
+inline void at_finalize(std::function<void()> hook)
+{
+    auto delete_fn = [](MPI_Comm, int, void *, void *extra_state) -> int {
+        auto *f = static_cast<std::function<void()> *>(extra_state);
+        (*f)();
+        delete f;
+        return MPI_SUCCESS;
+    };
+    int keyval;
+    CHECK_MPI(MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, delete_fn, &keyval,
+                                     new std::function<void()>(std::move(hook))));
+    CHECK_MPI(MPI_Comm_set_attr(MPI_COMM_SELF, keyval, nullptr));
+    CHECK_MPI(MPI_Comm_free_keyval(&keyval));
+}
+
 } // end namespace mpi
 
 #endif // MPI_ENVIRONMENT_HPP
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+#ifndef MPI_EXCHANGE_HPP
+#define MPI_EXCHANGE_HPP
+
+#include "communicator.hpp"
+#include "request.hpp"
+#include "status.hpp"
+#include <map>
+#include <vector>
+
+namespace mpi
+{
+
+inline constexpr int exchange_tag = 32765;
+
+// Sparse dynamic data exchange with the non-blocking consensus algorithm (NBX, Hoefler et al. 2010): every payload is
+// sent with issend, received payloads are found with iprobe, and once all sends of a rank have been matched it enters
+// an ibarrier; the exchange is over when the barrier completes. The cost grows with the number of peers, not with
+// the size of the communicator, and the receivers need not know their sources in advance.
+// Collective, returns the payloads received, keyed by source rank. A rank may leave while others still probe, so
+// back-to-back exchanges on the same communicator should alternate tags.
+template <typename T>
+std::map<int, std::vector<T>> sparse_exchange(const communicator &comm, const std::map<int, std::vector<T>> &outgoing,
+                                              int tag = exchange_tag)
+{
+    std::vector<request> sends;
+    sends.reserve(outgoing.size());
+    for (const auto &[dest, payload] : outgoing)
+    {
+        sends.push_back(comm.issend(payload.data(), payload.size(), dest, tag));
+    }
+
+    std::map<int, std::vector<T>> incoming;
+    request barrier;
+    bool barrier_active = false;
+    status st;
+    while (true)
+    {
+        if (comm.iprobe(MPI_ANY_SOURCE, tag, st))
+        {
+            auto &payload = incoming[st.source()];
+            payload.resize(st.get_count<T>());
+            comm.recv(payload.data(), payload.size(), st.source(), tag);
+        }
+        if (barrier_active)
+        {
+            if (barrier.test())
+                break;
+        }
+        else if (test_all(sends))
+        {
+            barrier = comm.ibarrier();
+            barrier_active = true;
+        }
+    }
+    return incoming;
+}
+
+} // end namespace mpi
+
+#endif // MPI_EXCHANGE_HPP
@@ -85,47 +85,56 @@ class file
     template <typename T>
     void read(T *buf, std::size_t count) const
     {
-        CHECK_MPI(MPI_File_read(m_file, buf, count, mpi_type<T>(), MPI_STATUS_IGNORE));
+        detail::large_count n(count, mpi_type<T>());
+        CHECK_MPI(MPICPP_COUNTED(MPI_File_read)(m_file, buf, n.count(), n.type(), MPI_STATUS_IGNORE));
     }
     template <typename T>
     void read(T *buf, std::size_t count, status &st) const
     {
-        CHECK_MPI(MPI_File_read(m_file, buf, count, mpi_type<T>(), st.ptr()));
+        detail::large_count n(count, mpi_type<T>());
+        CHECK_MPI(MPICPP_COUNTED(MPI_File_read)(m_file, buf, n.count(), n.type(), st.ptr()));
     }
     template <typename T>
     void read_all(T *buf, std::size_t count) const
     {
-        CHECK_MPI(MPI_File_read_all(m_file, buf, count, mpi_type<T>(), MPI_STATUS_IGNORE));
+        detail::large_count n(count, mpi_type<T>());
+        CHECK_MPI(MPICPP_COUNTED(MPI_File_read_all)(m_file, buf, n.count(), n.type(), MPI_STATUS_IGNORE));
     }
     template <typename T>
     void read_all(T *buf, std::size_t count, status &st) const
     {
-        CHECK_MPI(MPI_File_read_all(m_file, buf, count, mpi_type<T>(), st.ptr()));
+        detail::large_count n(count, mpi_type<T>());
+        CHECK_MPI(MPICPP_COUNTED(MPI_File_read_all)(m_file, buf, n.count(), n.type(), st.ptr()));
     }
     template <typename T>
     void read_at(MPI_Offset offset, T *buf, std::size_t count) const
     {
-        CHECK_MPI(MPI_File_read_at(m_file, offset, buf, count, mpi_type<T>(), MPI_STATUS_IGNORE));
+        detail::large_count n(count, mpi_type<T>());
+        CHECK_MPI(MPICPP_COUNTED(MPI_File_read_at)(m_file, offset, buf, n.count(), n.type(), MPI_STATUS_IGNORE));
     }
     template <typename T>
     void read_at(MPI_Offset offset, T *buf, std::size_t count, status &st) const
     {
-        CHECK_MPI(MPI_File_read_at(m_file, offset, buf, count, mpi_type<T>(), st.ptr()));
+        detail::large_count n(count, mpi_type<T>());
+        CHECK_MPI(MPICPP_COUNTED(MPI_File_read_at)(m_file, offset, buf, n.count(), n.type(), st.ptr()));
     }
     template <typename T>
     void read_at_all(MPI_Offset offset, T *buf, std::size_t count) const
     {
-        CHECK_MPI(MPI_File_read_at_all(m_file, offset, buf, count, mpi_type<T>(), MPI_STATUS_IGNORE));
+        detail::large_count n(count, mpi_type<T>());
+        CHECK_MPI(MPICPP_COUNTED(MPI_File_read_at_all)(m_file, offset, buf, n.count(), n.type(), MPI_STATUS_IGNORE));
     }
     template <typename T>
     void read_at_all(MPI_Offset offset, T *buf, std::size_t count, status &st) const
     {
-        CHECK_MPI(MPI_File_read_at_all(m_file, offset, buf, count, mpi_type<T>(), st.ptr()));
+        detail::large_count n(count, mpi_type<T>());
+        CHECK_MPI(MPICPP_COUNTED(MPI_File_read_at_all)(m_file, offset, buf, n.count(), n.type(), st.ptr()));
     }
     template <typename T>
     void read_at_all_begin(MPI_Offset offset, T *buf, std::size_t count)
     {
-        CHECK_MPI(MPI_File_read_at_all_begin(m_file, offset, buf, count, mpi_type<T>()));
+        detail::large_count n(count, mpi_type<T>());
+        CHECK_MPI(MPICPP_COUNTED(MPI_File_read_at_all_begin)(m_file, offset, buf, n.count(), n.type()));
     }
     template <typename T>
     void read_at_all_end(T *buf)
@@ -140,17 +149,20 @@ class file
     template <typename T>
     void read_ordered(T *buf, std::size_t count)
     {
-        CHECK_MPI(MPI_File_read_ordered(m_file, buf, count, mpi_type<T>(), MPI_STATUS_IGNORE));
+        detail::large_count n(count, mpi_type<T>());
+        CHECK_MPI(MPICPP_COUNTED(MPI_File_read_ordered)(m_file, buf, n.count(), n.type(), MPI_STATUS_IGNORE));
     }
     template <typename T>
     void read_ordered(T *buf, std::size_t count, status &st)
     {
-        CHECK_MPI(MPI_File_read_ordered(m_file, buf, count, mpi_type<T>(), st.ptr()));
+        detail::large_count n(count, mpi_type<T>());
+        CHECK_MPI(MPICPP_COUNTED(MPI_File_read_ordered)(m_file, buf, n.count(), n.type(), st.ptr()));
     }
     template <typename T>
     void read_ordered_begin(T *buf, std::size_t count)
     {
-        CHECK_MPI(MPI_File_read_ordered_begin(m_file, buf, count, mpi_type<T>()));
+        detail::large_count n(count, mpi_type<T>());
+        CHECK_MPI(MPICPP_COUNTED(MPI_File_read_ordered_begin)(m_file, buf, n.count(), n.type()));
     }
     template <typename T>
     void read_ordered_end(T *buf)
@@ -165,28 +177,33 @@ class file
     template <typename T>
     void read_shared(T *buf, std::size_t count)
     {
-        CHECK_MPI(MPI_File_read_shared(m_file, buf, count, mpi_type<T>(), MPI_STATUS_IGNORE));
+        detail::large_count n(count, mpi_type<T>());
+        CHECK_MPI(MPICPP_COUNTED(MPI_File_read_shared)(m_file, buf, n.count(), n.type(), MPI_STATUS_IGNORE));
     }
     template <typename T>
     void read_shared(T *buf, std::size_t count, status &st)
     {
-        CHECK_MPI(MPI_File_read_shared(m_file, buf, count, mpi_type<T>(), st.ptr()));
+        detail::large_count n(count, mpi_type<T>());
+        CHECK_MPI(MPICPP_COUNTED(MPI_File_read_shared)(m_file, buf, n.count(), n.type(), st.ptr()));
     }
 
     template <typename T>
     void write(const T *buf, std::size_t count)
     {
-        CHECK_MPI(MPI_File_write(m_file, buf, count, mpi_type<T>(), MPI_STATUS_IGNORE));
+        detail::large_count n(count, mpi_type<T>());
+        CHECK_MPI(MPICPP_COUNTED(MPI_File_write)(m_file, buf, n.count(), n.type(), MPI_STATUS_IGNORE));
     }
     template <typename T>
     void write(const T *buf, std::size_t count, status &st)
     {
-        CHECK_MPI(MPI_File_write(m_file, buf, count, mpi_type<T>(), st.ptr()));
+        detail::large_count n(count, mpi_type<T>());
+        CHECK_MPI(MPICPP_COUNTED(MPI_File_write)(m_file, buf, n.count(), n.type(), st.ptr()));
     }
     template <typename T>
     void write_all(const T *buf, std::size_t count)
     {
-        CHECK_MPI(MPI_File_write_all(m_file, buf, count, mpi_type<T>(), MPI_STATUS_IGNORE));
+        detail::large_count n(count, mpi_type<T>());
+        CHECK_MPI(MPICPP_COUNTED(MPI_File_write_all)(m_file, buf, n.count(), n.type(), MPI_STATUS_IGNORE));
     }
 };
 
@@ -7,6 +7,7 @@
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <string>
 
 namespace mpi
 {
@@ -77,6 +78,27 @@ class Logger
         write_log(LogLevel::Verbose, std::forward<Args>(args)...);
     }
 
+    bool enabled(LogLevel level) const { return static_cast<int>(level) <= static_cast<int>(m_log_level); }
+    // MPI_Wtime() at init(), the time in the prefix counts from here
+    double start_time() const { return m_start_time; }
+
+    // "[rank-hh:mm:ss] ", the rank padded to `rank_length`
+    static std::string prefix(int rank, std::size_t rank_length, double elapsed)
+    {
+        using namespace std::chrono_literals;
+        auto dura = elapsed * 1s;
+        std::ostringstream oss;
+        auto hours = std::chrono::floor<std::chrono::hours>(dura).count() % 24;
+        auto minutes = std::chrono::floor<std::chrono::minutes>(dura).count() % 60;
+        auto seconds = std::chrono::floor<std::chrono::seconds>(dura).count() % 60;
+        oss << '[';
+        oss << std::setw(rank_length) << rank << '-';
+        oss << std::setw(2) << std::setfill('0') << hours << ':';
+        oss << std::setw(2) << std::setfill('0') << minutes << ':';
+        oss << std::setw(2) << std::setfill('0') << seconds << "] ";
+        return oss.str();
+    }
+
   private:
     LogLevel m_log_level;
     double m_start_time;
@@ -91,21 +113,11 @@ class Logger
     template <typename... Args>
     void write_log(LogLevel level, Args &&...args) const
     {
-        using namespace std::chrono_literals;
         static const auto rank_length = std::to_string(world.size()).size();
-        if (static_cast<int>(level) > static_cast<int>(m_log_level))
+        if (!enabled(level))
             return;
-        auto now_time = MPI_Wtime();
-        auto dura = (now_time - m_start_time) * 1s;
         std::ostringstream oss;
-        auto hours = std::chrono::floor<std::chrono::hours>(dura).count() % 24;
-        auto minutes = std::chrono::floor<std::chrono::minutes>(dura).count() % 60;
-        auto seconds = std::chrono::floor<std::chrono::seconds>(dura).count() % 60;
-        oss << '[';
-        oss << std::setw(rank_length) << world.rank() << '-';
-        oss << std::setw(2) << std::setfill('0') << hours << ':';
-        oss << std::setw(2) << std::setfill('0') << minutes << ':';
-        oss << std::setw(2) << std::setfill('0') << seconds << "] ";
+        oss << prefix(world.rank(), rank_length, MPI_Wtime() - m_start_time);
         (oss << ... << args) << '\n';
         std::cout << oss.str();
         std::cout.flush();
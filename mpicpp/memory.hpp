@@ -0,0 +1,256 @@
+#pragma once
+#ifndef MPI_MEMORY_HPP
+#define MPI_MEMORY_HPP
+
+#include "error.hpp"
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mpi
+{
+
+// ----- MPI_Alloc_mem -----
+
+// Allocates with MPI_Alloc_mem, which returns memory registered with the network on RDMA interconnects, so
+// sends and receives from it need no registration or bounce buffer. Only usable between MPI_Init and MPI_Finalize:
+// containers using it must be destroyed before the environment.
+template <typename T>
+class alloc_mem_allocator
+{
+  public:
+    using value_type = T;
+
+    alloc_mem_allocator() = default;
+    template <typename U>
+    alloc_mem_allocator(const alloc_mem_allocator<U> &)
+    {
+    }
+
+    T *allocate(std::size_t n)
+    {
+        T *ptr;
+        CHECK_MPI(MPI_Alloc_mem(static_cast<MPI_Aint>(n * sizeof(T)), MPI_INFO_NULL, &ptr));
+        return ptr;
+    }
+    void deallocate(T *ptr, std::size_t) { CHECK_MPI(MPI_Free_mem(ptr)); }
+
+    template <typename U>
+    bool operator==(const alloc_mem_allocator<U> &) const
+    {
+        return true;
+    }
+};
+
+// ----- buffer pool -----
+
+// Caches freed blocks in power-of-two size buckets, so the receive buffers of repeated messages do not go back to
+// the system allocator every time. Blocks are 64-byte aligned; blocks above `max_pooled_bytes` are not cached.
+// Thread-safe.
+class buffer_pool
+{
+  public:
+    static constexpr std::size_t min_block_bytes = 64;
+    static constexpr std::size_t max_pooled_bytes = std::size_t(1) << 30;
+    static constexpr std::size_t max_cached_blocks = 16; // per bucket
+    static constexpr std::size_t alignment = 64;
+
+    struct statistics
+    {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t cached_bytes = 0;
+    };
+
+  private:
+    static constexpr std::size_t buckets = 25; // 64 B .. 1 GiB
+
+    mutable std::mutex m_mutex;
+    std::array<std::vector<void *>, buckets> m_free;
+    statistics m_stats;
+
+    static std::size_t bucket(std::size_t bytes)
+    {
+        std::size_t b = 0;
+        while ((min_block_bytes << b) < bytes)
+        {
+            ++b;
+        }
+        return b;
+    }
+    static void *allocate(std::size_t bytes) { return ::operator new(bytes, std::align_val_t{alignment}); }
+    static void deallocate(void *ptr) { ::operator delete(ptr, std::align_val_t{alignment}); }
+
+  public:
+    buffer_pool() = default;
+    buffer_pool(const buffer_pool &) = delete;
+    buffer_pool &operator=(const buffer_pool &) = delete;
+    ~buffer_pool() { trim(); }
+
+    static buffer_pool &instance()
+    {
+        static buffer_pool pool;
+        return pool;
+    }
+
+    // a block of at least `bytes`, to be given back with release(ptr, bytes)
+    void *acquire(std::size_t bytes)
+    {
+        if (bytes > max_pooled_bytes)
+            return allocate(bytes);
+        const std::size_t b = bucket(bytes);
+        {
+            std::lock_guard lock(m_mutex);
+            if (!m_free[b].empty())
+            {
+                void *ptr = m_free[b].back();
+                m_free[b].pop_back();
+                ++m_stats.hits;
+                m_stats.cached_bytes -= min_block_bytes << b;
+                return ptr;
+            }
+            ++m_stats.misses;
+        }
+        return allocate(min_block_bytes << b);
+    }
+
+    void release(void *ptr, std::size_t bytes)
+    {
+        if (bytes <= max_pooled_bytes)
+        {
+            const std::size_t b = bucket(bytes);
+            std::lock_guard lock(m_mutex);
+            if (m_free[b].size() < max_cached_blocks)
+            {
+                m_free[b].push_back(ptr);
+                m_stats.cached_bytes += min_block_bytes << b;
+                return;
+            }
+        }
+        deallocate(ptr);
+    }
+
+    // give every cached block back to the system
+    void trim()
+    {
+        std::lock_guard lock(m_mutex);
+        for (auto &blocks : m_free)
+        {
+            for (void *ptr : blocks)
+            {
+                deallocate(ptr);
+            }
+            blocks.clear();
+        }
+        m_stats.cached_bytes = 0;
+    }
+
+    statistics stats() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_stats;
+    }
+};
+
+template <typename T>
+class pool_allocator
+{
+    static_assert(alignof(T) <= buffer_pool::alignment, "pool_allocator<T>: T is over-aligned");
+
+  public:
+    using value_type = T;
+
+    pool_allocator() = default;
+    template <typename U>
+    pool_allocator(const pool_allocator<U> &)
+    {
+    }
+
+    T *allocate(std::size_t n) { return static_cast<T *>(buffer_pool::instance().acquire(n * sizeof(T))); }
+    void deallocate(T *ptr, std::size_t n) { buffer_pool::instance().release(ptr, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const pool_allocator<U> &) const
+    {
+        return true;
+    }
+};
+
+// ----- default initialization -----
+
+// Constructs elements without arguments by default initialization instead of value initialization, so resize()
+// leaves trivial elements uninitialized instead of zero-filling memory that a receive overwrites anyway.
+template <typename T, typename Alloc = std::allocator<T>>
+class default_init_allocator : public Alloc
+{
+    using traits = std::allocator_traits<Alloc>;
+
+  public:
+    template <typename U>
+    struct rebind
+    {
+        using other = default_init_allocator<U, typename traits::template rebind_alloc<U>>;
+    };
+
+    using Alloc::Alloc;
+    default_init_allocator() = default;
+    template <typename U, typename A>
+    default_init_allocator(const default_init_allocator<U, A> &other) : Alloc(static_cast<const A &>(other))
+    {
+    }
+
+    template <typename U>
+    void construct(U *ptr) noexcept(std::is_nothrow_default_constructible_v<U>)
+    {
+        ::new (static_cast<void *>(ptr)) U;
+    }
+    template <typename U, typename... Args>
+    void construct(U *ptr, Args &&...args)
+    {
+        traits::construct(static_cast<Alloc &>(*this), ptr, std::forward<Args>(args)...);
+    }
+
+    template <typename U, typename A>
+    bool operator==(const default_init_allocator<U, A> &other) const
+    {
+        return static_cast<const Alloc &>(*this) == static_cast<const A &>(other);
+    }
+};
+
+// A receive buffer: pooled storage and no zero-fill on resize, which a receive into a std::vector still pays.
+template <typename T>
+using buffer = std::vector<T, default_init_allocator<T, pool_allocator<T>>>;
+
+namespace detail
+{
+
+// Resize a container which is about to be overwritten by a receive. A vector cannot skip the initialization itself:
+// with std::allocator (a plain std::vector) the new elements are still zero-filled, only an allocator which
+// default-initializes, like the one of mpi::buffer, leaves them as they are.
+template <typename T, typename Alloc>
+void resize_for_overwrite(std::vector<T, Alloc> &data, std::size_t size)
+{
+    data.resize(size);
+}
+
+template <typename Traits, typename Alloc>
+void resize_for_overwrite(std::basic_string<char, Traits, Alloc> &str, std::size_t size)
+{
+#ifdef __cpp_lib_string_resize_and_overwrite
+    str.resize_and_overwrite(size, [](char *, std::size_t n) { return n; });
+#else
+    str.resize(size);
+#endif
+}
+
+} // end namespace detail
+
+} // end namespace mpi
+
+#endif // MPI_MEMORY_HPP
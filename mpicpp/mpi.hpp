@@ -2,15 +2,38 @@
 #ifndef MPI_HPP
 #define MPI_HPP
 
+#include "active_message.hpp"
+#include "aggregator.hpp"
 #include "communicator.hpp"
+#include "compress.hpp"
+#include "distributed_vector.hpp"
 #include "environment.hpp"
 #include "error.hpp"
+#include "exchange.hpp"
 #include "file.hpp"
 #include "info.hpp"
 #include "logger.hpp"
+#include "memory.hpp"
+#include "partition.hpp"
+#include "partitioned.hpp"
+#include "pipeline.hpp"
+#include "progress.hpp"
+#include "reduction.hpp"
+#include "reorder.hpp"
 #include "request.hpp"
+#include "serialize.hpp"
+#include "sort.hpp"
 #include "status.hpp"
+#include "task_pool.hpp"
+#include "threads.hpp"
+#include "timer.hpp"
 #include "tools.hpp"
+#include "tracking.hpp"
+#include "traffic.hpp"
+#include "transpose.hpp"
+#include "tuned.hpp"
 #include "types.hpp"
+#include "view.hpp"
+#include "watchdog.hpp"
 
 #endif // MPI_HPP
\ No newline at end of file
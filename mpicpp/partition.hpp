@@ -0,0 +1,102 @@
+#pragma once
+#ifndef MPI_PARTITION_HPP
+#define MPI_PARTITION_HPP
+
+#include "communicator.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace mpi
+{
+
+// Block partition of `total` elements over `parts` ranks, the first `total % parts` ranks get one extra element.
+class block_partition
+{
+  private:
+    std::size_t m_total;
+    std::size_t m_parts;
+
+  public:
+    block_partition() : m_total(0), m_parts(1) {}
+    block_partition(std::size_t total, std::size_t parts) : m_total(total), m_parts(parts) {}
+
+    std::size_t total() const { return m_total; }
+    std::size_t parts() const { return m_parts; }
+    std::size_t size(std::size_t part) const { return m_total / m_parts + (part < m_total % m_parts ? 1 : 0); }
+    std::size_t begin(std::size_t part) const
+    {
+        std::size_t q = m_total / m_parts, r = m_total % m_parts;
+        return part * q + (part < r ? part : r);
+    }
+    std::size_t end(std::size_t part) const { return begin(part) + size(part); }
+    // the p + 1 global offsets of the parts
+    std::vector<std::size_t> offsets() const
+    {
+        std::vector<std::size_t> result(m_parts + 1);
+        for (std::size_t i = 0; i <= m_parts; ++i)
+        {
+            result[i] = begin(i);
+        }
+        return result;
+    }
+    // the part which holds global index `index`
+    std::size_t owner(std::size_t index) const
+    {
+        std::size_t q = m_total / m_parts, r = m_total % m_parts;
+        if (index < r * (q + 1))
+            return index / (q + 1);
+        return r + (index - r * (q + 1)) / q;
+    }
+};
+
+// Move the elements of a distributed vector (concatenated in rank order) from the layout `from` to the layout `to`,
+// both given as p + 1 global offsets known on every rank. One alltoallv, no other collective.
+template <typename T>
+void redistribute(const communicator &comm, std::vector<T> &data, const std::vector<std::size_t> &from,
+                  const std::vector<std::size_t> &to)
+{
+    const int p = comm.size();
+    const int me = comm.rank();
+    assert(from.back() == to.back() && "redistribute: layouts have different global sizes");
+    auto overlap = [](std::size_t b1, std::size_t e1, std::size_t b2, std::size_t e2) {
+        std::size_t b = std::max(b1, b2), e = std::min(e1, e2);
+        return static_cast<int>(e > b ? e - b : 0);
+    };
+    std::vector<int> send_counts(p), send_displs(p, 0), recv_counts(p), recv_displs(p, 0);
+    for (int r = 0; r < p; ++r)
+    {
+        send_counts[r] = overlap(from[me], from[me + 1], to[r], to[r + 1]);
+        recv_counts[r] = overlap(from[r], from[r + 1], to[me], to[me + 1]);
+    }
+    for (int r = 1; r < p; ++r)
+    {
+        send_displs[r] = send_displs[r - 1] + send_counts[r - 1];
+        recv_displs[r] = recv_displs[r - 1] + recv_counts[r - 1];
+    }
+    std::vector<T> result(to[me + 1] - to[me]);
+    comm.alltoallv(data.data(), send_counts.data(), send_displs.data(), result.data(), recv_counts.data(),
+                   recv_displs.data());
+    data.swap(result);
+}
+
+// Same as above when the current layout is not known: the local sizes are allgathered first.
+template <typename T>
+void redistribute(const communicator &comm, std::vector<T> &data, const block_partition &target)
+{
+    const int p = comm.size();
+    std::size_t n = data.size();
+    std::vector<std::size_t> sizes(p);
+    comm.allgather(n, sizes.data());
+    std::vector<std::size_t> from(p + 1, 0);
+    for (int r = 0; r < p; ++r)
+    {
+        from[r + 1] = from[r] + sizes[r];
+    }
+    redistribute(comm, data, from, target.offsets());
+}
+
+} // end namespace mpi
+
+#endif // MPI_PARTITION_HPP
@@ -0,0 +1,186 @@
+#pragma once
+#ifndef MPI_PARTITIONED_HPP
+#define MPI_PARTITIONED_HPP
+
+#include "communicator.hpp"
+#include "traffic.hpp"
+#include "types.hpp"
+#include <cassert>
+#include <climits>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace mpi
+{
+
+// Partitioned point-to-point communication: one buffer of `partitions` x `count` elements, whose partitions the
+// sending threads mark ready one by one, so each partition can leave as soon as its thread has produced it instead
+// of after a join of all threads. MPI-4 provides this as MPI_Psend_init / MPI_Pready / MPI_Parrived. Before MPI-4 it
+// is emulated with one persistent send and receive per partition, matched by tags tag ... tag + partitions - 1 on
+// the communicator, which the application must leave free. Both objects are persistent: start() / ready() / wait()
+// as often as needed; the destructors wait and free the requests. Calls from several threads need
+// MPI_THREAD_MULTIPLE (the emulation only needs MPI_THREAD_SERIALIZED).
+
+#if MPI_VERSION >= 4 && !defined(MPICPP_NO_PARTITIONED)
+#define MPICPP_PARTITIONED
+#endif
+
+namespace detail
+{
+
+class partitioned_base
+{
+  protected:
+    std::size_t m_partitions;
+    std::size_t m_count;
+#ifdef MPICPP_PARTITIONED
+    MPI_Request m_request = MPI_REQUEST_NULL;
+#else
+    std::vector<MPI_Request> m_requests;
+    // the emulation starts and tests the per-partition requests from many threads
+    std::mutex m_mutex;
+#endif
+
+    partitioned_base(std::size_t partitions, std::size_t count) : m_partitions(partitions), m_count(count)
+    {
+        assert(partitions > 0);
+#ifndef MPICPP_PARTITIONED
+        m_requests.assign(partitions, MPI_REQUEST_NULL);
+        assert(partitions <= static_cast<std::size_t>(INT_MAX));
+#endif
+    }
+    partitioned_base(const partitioned_base &) = delete;
+    partitioned_base &operator=(const partitioned_base &) = delete;
+    ~partitioned_base()
+    {
+        wait();
+#ifdef MPICPP_PARTITIONED
+        if (m_request != MPI_REQUEST_NULL)
+            MPI_Request_free(&m_request);
+#else
+        for (auto &req : m_requests)
+        {
+            if (req != MPI_REQUEST_NULL)
+                MPI_Request_free(&req);
+        }
+#endif
+    }
+
+  public:
+    std::size_t partitions() const { return m_partitions; }
+    // elements per partition
+    std::size_t count() const { return m_count; }
+
+    // completes the round started by start(), every partition must have been marked ready (send side)
+    void wait()
+    {
+#ifdef MPICPP_PARTITIONED
+        if (m_request != MPI_REQUEST_NULL)
+            CHECK_MPI(MPI_Wait(&m_request, MPI_STATUS_IGNORE));
+#else
+        // inactive persistent requests complete at once
+        CHECK_MPI(MPI_Waitall(static_cast<int>(m_requests.size()), m_requests.data(), MPI_STATUSES_IGNORE));
+#endif
+    }
+};
+
+} // end namespace detail
+
+// The send side: start() a round, ready(k) from the thread which has produced partition k, wait().
+template <typename T>
+class partitioned_send : public detail::partitioned_base
+{
+  private:
+    MPI_Comm m_comm;
+    int m_dest;
+
+  public:
+    partitioned_send(const communicator &comm, const T *data, std::size_t partitions, std::size_t count, int dest,
+                     int tag)
+        : partitioned_base(partitions, count), m_comm(comm.data()), m_dest(dest)
+    {
+        check_type<T>();
+#ifdef MPICPP_PARTITIONED
+        CHECK_MPI(MPI_Psend_init(data, static_cast<int>(partitions), static_cast<MPI_Count>(count), mpi_type<T>(),
+                                 dest, tag, m_comm, MPI_INFO_NULL, &m_request));
+#else
+        for (std::size_t k = 0; k < partitions; ++k)
+        {
+            detail::large_count n(count, mpi_type<T>());
+            CHECK_MPI(MPICPP_COUNTED(MPI_Send_init)(data + k * count, n.count(), n.type(), dest,
+                                                    tag + static_cast<int>(k), m_comm, &m_requests[k]));
+        }
+#endif
+    }
+
+    void start()
+    {
+        detail::record_traffic(m_comm, m_dest, m_partitions * m_count * sizeof(T));
+#ifdef MPICPP_PARTITIONED
+        CHECK_MPI(MPI_Start(&m_request));
+#endif
+    }
+
+    // partition k may leave, thread-safe
+    void ready(std::size_t partition)
+    {
+        assert(partition < m_partitions);
+#ifdef MPICPP_PARTITIONED
+        CHECK_MPI(MPI_Pready(static_cast<int>(partition), m_request));
+#else
+        std::lock_guard lock(m_mutex);
+        CHECK_MPI(MPI_Start(&m_requests[partition]));
+#endif
+    }
+};
+
+// The receive side: start() a round, poll arrived(k) to consume partitions early, or wait() for all of them.
+template <typename T>
+class partitioned_recv : public detail::partitioned_base
+{
+  public:
+    partitioned_recv(const communicator &comm, T *data, std::size_t partitions, std::size_t count, int src, int tag)
+        : partitioned_base(partitions, count)
+    {
+        check_type<T>();
+#ifdef MPICPP_PARTITIONED
+        CHECK_MPI(MPI_Precv_init(data, static_cast<int>(partitions), static_cast<MPI_Count>(count), mpi_type<T>(),
+                                 src, tag, comm.data(), MPI_INFO_NULL, &m_request));
+#else
+        for (std::size_t k = 0; k < partitions; ++k)
+        {
+            detail::large_count n(count, mpi_type<T>());
+            CHECK_MPI(MPICPP_COUNTED(MPI_Recv_init)(data + k * count, n.count(), n.type(), src,
+                                                    tag + static_cast<int>(k), comm.data(), &m_requests[k]));
+        }
+#endif
+    }
+
+    void start()
+    {
+#ifdef MPICPP_PARTITIONED
+        CHECK_MPI(MPI_Start(&m_request));
+#else
+        CHECK_MPI(MPI_Startall(static_cast<int>(m_requests.size()), m_requests.data()));
+#endif
+    }
+
+    // partition k of the current round is in the buffer, thread-safe
+    bool arrived(std::size_t partition)
+    {
+        assert(partition < m_partitions);
+        int flag;
+#ifdef MPICPP_PARTITIONED
+        CHECK_MPI(MPI_Parrived(m_request, static_cast<int>(partition), &flag));
+#else
+        std::lock_guard lock(m_mutex);
+        CHECK_MPI(MPI_Test(&m_requests[partition], &flag, MPI_STATUS_IGNORE));
+#endif
+        return flag;
+    }
+};
+
+} // end namespace mpi
+
+#endif // MPI_PARTITIONED_HPP
@@ -0,0 +1,188 @@
+#pragma once
+#ifndef MPI_PIPELINE_HPP
+#define MPI_PIPELINE_HPP
+
+#include "communicator.hpp"
+#include "request.hpp"
+#include "types.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace mpi
+{
+
+// Segmented broadcast and reduce for very large buffers. The buffer is cut into segments which travel along a chain
+// or a binary tree rooted at `root` with non-blocking point-to-point messages, so a rank forwards segment s while
+// segment s + 1 is still arriving. The messages use `pipeline_tag` on the given communicator; pass a duplicate if the
+// application also uses that tag.
+
+enum class pipeline
+{
+    chain,
+    binary_tree
+};
+
+inline constexpr int pipeline_tag = 32767; // the smallest MPI_TAG_UB allowed by the standard
+inline constexpr std::size_t pipeline_segment_bytes = 256 * 1024;
+
+namespace detail
+{
+
+struct pipeline_node
+{
+    int parent; // -1 on the root
+    std::vector<int> children;
+};
+
+inline pipeline_node pipeline_neighbours(int rank, int size, int root, pipeline topology)
+{
+    const int vrank = (rank - root + size) % size;
+    auto real = [&](int v) { return (v + root) % size; };
+    pipeline_node node{-1, {}};
+    if (topology == pipeline::chain)
+    {
+        if (vrank > 0)
+            node.parent = real(vrank - 1);
+        if (vrank + 1 < size)
+            node.children.push_back(real(vrank + 1));
+    }
+    else
+    {
+        if (vrank > 0)
+            node.parent = real((vrank - 1) / 2);
+        for (int child : {2 * vrank + 1, 2 * vrank + 2})
+        {
+            if (child < size)
+                node.children.push_back(real(child));
+        }
+    }
+    return node;
+}
+
+} // end namespace detail
+
+template <typename T>
+void pipelined_broadcast(const communicator &comm, T *buf, std::size_t count, int root,
+                         std::size_t segment_bytes = pipeline_segment_bytes, pipeline topology = pipeline::binary_tree)
+{
+    check_type<T>();
+    const auto node = detail::pipeline_neighbours(comm.rank(), comm.size(), root, topology);
+    const std::size_t seg = std::max<std::size_t>(1, segment_bytes / sizeof(T));
+    const std::size_t nseg = (count + seg - 1) / seg;
+    auto length = [&](std::size_t s) { return std::min(seg, count - s * seg); };
+
+    std::vector<request> recvs;
+    if (node.parent >= 0)
+    {
+        recvs.reserve(nseg);
+        for (std::size_t s = 0; s < nseg; ++s)
+        {
+            recvs.push_back(comm.irecv(buf + s * seg, length(s), node.parent, pipeline_tag));
+        }
+    }
+    std::vector<request> sends;
+    sends.reserve(nseg * node.children.size());
+    for (std::size_t s = 0; s < nseg; ++s)
+    {
+        if (node.parent >= 0)
+            recvs[s].wait();
+        for (int child : node.children)
+        {
+            sends.push_back(comm.isend(buf + s * seg, length(s), child, pipeline_tag));
+        }
+    }
+    wait_all(sends);
+}
+
+// the size is broadcast first, like communicator::broadcast.
+template <typename T>
+void pipelined_broadcast(const communicator &comm, std::vector<T> &data, int root,
+                         std::size_t segment_bytes = pipeline_segment_bytes, pipeline topology = pipeline::binary_tree)
+{
+    std::size_t size = data.size();
+    comm.broadcast(size, root);
+    if (comm.rank() != root)
+    {
+        data.resize(size);
+    }
+    pipelined_broadcast(comm, data.data(), size, root, segment_bytes, topology);
+}
+
+// The tree does not combine in rank order: a non-commutative `op` falls back to communicator::reduce. Every rank keeps
+// two segments per child in flight; non-root ranks also need a copy of `send_data` to accumulate into.
+template <typename T>
+void pipelined_reduce(const communicator &comm, const T *send_data, T *recv_data, std::size_t count, MPI_Op op,
+                      int root, std::size_t segment_bytes = pipeline_segment_bytes,
+                      pipeline topology = pipeline::binary_tree)
+{
+    check_type<T>();
+    int commutative;
+    CHECK_MPI(MPI_Op_commutative(op, &commutative));
+    if (!commutative)
+    {
+        comm.reduce(send_data, recv_data, count, op, root);
+        return;
+    }
+    const auto node = detail::pipeline_neighbours(comm.rank(), comm.size(), root, topology);
+    const std::size_t seg = std::max<std::size_t>(1, segment_bytes / sizeof(T));
+    const std::size_t nseg = (count + seg - 1) / seg;
+    auto length = [&](std::size_t s) { return std::min(seg, count - s * seg); };
+
+    std::vector<T> local;
+    T *acc = recv_data;
+    if (node.parent >= 0)
+    {
+        local.assign(send_data, send_data + count);
+        acc = local.data();
+    }
+    else
+    {
+        std::copy(send_data, send_data + count, recv_data);
+    }
+
+    const std::size_t nchild = node.children.size();
+    std::vector<T> slots(nchild * 2 * seg);
+    std::vector<request> pending(nchild * 2);
+    auto post = [&](std::size_t c, std::size_t s) {
+        std::size_t slot = c * 2 + s % 2;
+        pending[slot] = comm.irecv(slots.data() + slot * seg, length(s), node.children[c], pipeline_tag);
+    };
+    for (std::size_t c = 0; c < nchild; ++c)
+    {
+        for (std::size_t s = 0; s < std::min<std::size_t>(2, nseg); ++s)
+        {
+            post(c, s);
+        }
+    }
+
+    std::vector<request> sends;
+    sends.reserve(node.parent >= 0 ? nseg : 0);
+    for (std::size_t s = 0; s < nseg; ++s)
+    {
+        for (std::size_t c = 0; c < nchild; ++c)
+        {
+            std::size_t slot = c * 2 + s % 2;
+            pending[slot].wait();
+            CHECK_MPI(MPI_Reduce_local(slots.data() + slot * seg, acc + s * seg, length(s), mpi_type<T>(), op));
+            if (s + 2 < nseg)
+                post(c, s + 2);
+        }
+        if (node.parent >= 0)
+            sends.push_back(comm.isend(acc + s * seg, length(s), node.parent, pipeline_tag));
+    }
+    wait_all(sends);
+}
+
+// `commute` as for communicator::reduce with a functor, only a commutative functor is pipelined
+template <typename T, reduction_functor<T> Func>
+void pipelined_reduce(const communicator &comm, const T *send_data, T *recv_data, std::size_t count, Func func,
+                      int root, std::size_t segment_bytes = pipeline_segment_bytes,
+                      pipeline topology = pipeline::binary_tree, bool commute = false)
+{
+    pipelined_reduce(comm, send_data, recv_data, count, functor_op<T, Func>(std::move(func), commute).get(), root,
+                     segment_bytes, topology);
+}
+
+} // end namespace mpi
+
+#endif // MPI_PIPELINE_HPP
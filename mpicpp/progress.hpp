@@ -0,0 +1,203 @@
+#pragma once
+#ifndef MPI_PROGRESS_HPP
+#define MPI_PROGRESS_HPP
+
+#include "environment.hpp"
+#include "request.hpp"
+#include "status.hpp"
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace mpi
+{
+
+namespace detail
+{
+
+struct completion_state
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+    status st;
+};
+
+} // end namespace detail
+
+// Returned by progress_engine::submit, signalled by the progress thread when the request has completed.
+class completion
+{
+  private:
+    std::shared_ptr<detail::completion_state> m_state;
+
+  public:
+    explicit completion(std::shared_ptr<detail::completion_state> state) : m_state(std::move(state)) {}
+    bool ready() const
+    {
+        std::lock_guard lock(m_state->mutex);
+        return m_state->done;
+    }
+    // blocks without calling MPI
+    void wait() const
+    {
+        std::unique_lock lock(m_state->mutex);
+        m_state->cv.wait(lock, [this]() { return m_state->done; });
+    }
+    status get_status() const
+    {
+        wait();
+        return m_state->st;
+    }
+};
+
+struct progress_options
+{
+    // pause between two rounds of MPI_Testsome, zero only yields
+    std::chrono::microseconds interval{20};
+    // pin the progress thread to this CPU (Linux only), -1 leaves it to the scheduler
+    int cpu = -1;
+};
+
+// Many MPI libraries only progress non-blocking operations inside MPI calls. The progress engine owns submitted
+// requests and tests them from a dedicated thread, so the transfers advance while the application computes; the
+// waiters block on a completion instead of in MPI. Needs MPI_THREAD_MULTIPLE. The thread sleeps while it has no
+// requests. The destructor waits for every submitted request.
+class progress_engine
+{
+  private:
+    using state_ptr = std::shared_ptr<detail::completion_state>;
+
+    progress_options m_options;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<request> m_submitted;
+    std::vector<state_ptr> m_submitted_states;
+    bool m_stop = false;
+    std::thread m_thread;
+
+  public:
+    explicit progress_engine(progress_options options = {}) : m_options(options)
+    {
+        assert(environment::query_thread_level() == thread_level::multiple &&
+               "progress_engine needs MPI_THREAD_MULTIPLE");
+        m_thread = std::thread([this]() { run(); });
+#ifdef __linux__
+        if (m_options.cpu >= 0)
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(m_options.cpu, &set);
+            pthread_setaffinity_np(m_thread.native_handle(), sizeof(set), &set);
+        }
+#endif
+    }
+    progress_engine(const progress_engine &) = delete;
+    progress_engine &operator=(const progress_engine &) = delete;
+    ~progress_engine()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_one();
+        m_thread.join();
+    }
+
+    // a null request (default-constructed, or already completed) is done at once, MPI_Testsome would skip it
+    completion submit(request req)
+    {
+        auto state = std::make_shared<detail::completion_state>();
+        if (!req.valid())
+        {
+            state->done = true;
+            return completion(std::move(state));
+        }
+        {
+            std::lock_guard lock(m_mutex);
+            m_submitted.push_back(std::move(req));
+            m_submitted_states.push_back(state);
+        }
+        m_cv.notify_one();
+        return completion(std::move(state));
+    }
+
+  private:
+    void run()
+    {
+        std::vector<request> active;
+        std::vector<state_ptr> states;
+        std::vector<int> indices;
+        std::vector<status> statuses;
+        while (true)
+        {
+            {
+                std::unique_lock lock(m_mutex);
+                if (active.empty())
+                    m_cv.wait(lock, [this]() { return m_stop || !m_submitted.empty(); });
+                if (m_stop && active.empty() && m_submitted.empty())
+                    return;
+                for (std::size_t i = 0; i < m_submitted.size(); ++i)
+                {
+                    active.push_back(std::move(m_submitted[i]));
+                    states.push_back(std::move(m_submitted_states[i]));
+                }
+                m_submitted.clear();
+                m_submitted_states.clear();
+            }
+
+            int outcount;
+            indices.resize(active.size());
+            statuses.resize(active.size());
+            auto *handles = reinterpret_cast<MPI_Request *>(active.data());
+            detail::watch_requests watch(handles, active.size(), false);
+            CHECK_MPI(MPI_Testsome(active.size(), handles, &outcount, indices.data(),
+                                   reinterpret_cast<MPI_Status *>(statuses.data())));
+            watch.done();
+            for (int i = 0; i < outcount; ++i)
+            {
+                auto &state = *states[indices[i]];
+                {
+                    std::lock_guard lock(state.mutex);
+                    state.st = statuses[i];
+                    state.done = true;
+                }
+                state.cv.notify_all();
+            }
+            // MPI_Testsome has set the completed requests to MPI_REQUEST_NULL
+            for (std::size_t i = 0; i < active.size();)
+            {
+                if (!active[i].valid())
+                {
+                    active[i] = std::move(active.back());
+                    active.pop_back();
+                    states[i] = std::move(states.back());
+                    states.pop_back();
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+
+            if (active.empty())
+                continue;
+            if (m_options.interval.count() > 0)
+                std::this_thread::sleep_for(m_options.interval);
+            else
+                std::this_thread::yield();
+        }
+    }
+};
+
+} // end namespace mpi
+
+#endif // MPI_PROGRESS_HPP
@@ -0,0 +1,198 @@
+#pragma once
+#ifndef MPI_REDUCTION_HPP
+#define MPI_REDUCTION_HPP
+
+#include "types.hpp"
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Reduction functors for op::custom with a block overload `f(const T *in, T *inout, std::size_t n)`, which the user op
+// callback calls on the whole buffer. The loops are written so the compiler can vectorize them: no aliasing between
+// `in` and `inout`, no loop-carried dependence and branch-free selects.
+
+#if defined(__clang__)
+#define MPICPP_VECTORIZE _Pragma("clang loop vectorize(enable) interleave(enable)")
+#elif defined(__GNUC__)
+#define MPICPP_VECTORIZE _Pragma("GCC ivdep")
+#else
+#define MPICPP_VECTORIZE
+#endif
+
+#if defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)
+#define MPICPP_RESTRICT __restrict
+#else
+#define MPICPP_RESTRICT
+#endif
+
+namespace mpi
+{
+
+// ----- compensated sum -----
+
+// A sum with its rounding error, reduced with compensated_sum it is as accurate as summing in twice the precision.
+// Do not compile with -ffast-math, it removes the error term.
+template <typename T>
+struct compensated
+{
+    static_assert(std::is_floating_point_v<T>, "compensated<T> needs a floating point T");
+    T sum;
+    T err;
+
+    T value() const { return sum + err; }
+    static MPI_Datatype mpi_type()
+    {
+        static const MPI_Datatype type = []() {
+            MPI_Datatype t;
+            CHECK_MPI(MPI_Type_contiguous(2, mpi::mpi_type<T>(), &t));
+            return commit_type(t);
+        }();
+        return type;
+    }
+};
+
+template <typename T>
+struct compensated_sum
+{
+    // TwoSum of the partial sums, the errors are added without compensation.
+    static compensated<T> combine(const compensated<T> &a, const compensated<T> &b)
+    {
+        T s = a.sum + b.sum;
+        T bb = s - a.sum;
+        T e = (a.sum - (s - bb)) + (b.sum - bb);
+        return compensated<T>{s, e + a.err + b.err};
+    }
+    // local accumulation before the reduction
+    static compensated<T> accumulate(compensated<T> acc, T x) { return combine(acc, compensated<T>{x, T{}}); }
+
+    compensated<T> operator()(const compensated<T> &a, const compensated<T> &b) const { return combine(a, b); }
+    void operator()(const compensated<T> *MPICPP_RESTRICT in, compensated<T> *MPICPP_RESTRICT inout,
+                    std::size_t n) const
+    {
+        MPICPP_VECTORIZE
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            inout[i] = combine(in[i], inout[i]);
+        }
+    }
+};
+
+// ----- absmax -----
+
+// Real T: the largest absolute value. Complex T: the element with the largest modulus (compared by std::norm, so no
+// square root).
+template <typename T>
+struct absmax
+{
+    static T combine(const T &a, const T &b)
+    {
+        if constexpr (detail::is_complex<T>::value)
+        {
+            return std::norm(b) > std::norm(a) ? b : a;
+        }
+        else
+        {
+            T x = std::abs(a), y = std::abs(b);
+            return y > x ? y : x;
+        }
+    }
+
+    T operator()(const T &a, const T &b) const { return combine(a, b); }
+    void operator()(const T *MPICPP_RESTRICT in, T *MPICPP_RESTRICT inout, std::size_t n) const
+    {
+        if constexpr (detail::is_complex<T>::value)
+        {
+            // on the interleaved real/imaginary parts, std::norm would not vectorize.
+            using R = typename T::value_type;
+            const R *a = reinterpret_cast<const R *>(in);
+            R *b = reinterpret_cast<R *>(inout);
+            MPICPP_VECTORIZE
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                R na = a[2 * i] * a[2 * i] + a[2 * i + 1] * a[2 * i + 1];
+                R nb = b[2 * i] * b[2 * i] + b[2 * i + 1] * b[2 * i + 1];
+                bool take = na > nb;
+                b[2 * i] = take ? a[2 * i] : b[2 * i];
+                b[2 * i + 1] = take ? a[2 * i + 1] : b[2 * i + 1];
+            }
+        }
+        else
+        {
+            MPICPP_VECTORIZE
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                T x = std::abs(in[i]), y = std::abs(inout[i]);
+                inout[i] = x > y ? x : y;
+            }
+        }
+    }
+};
+
+// ----- min/max with index -----
+
+// A value with the position it came from, like the pairs of MPI_MINLOC/MPI_MAXLOC but with a 64-bit index and any
+// ordered T. Ties keep the smaller index.
+template <typename T>
+struct value_index
+{
+    T value;
+    std::int64_t index;
+
+    static MPI_Datatype mpi_type()
+    {
+        static const MPI_Datatype type = []() {
+            int lengths[2] = {1, 1};
+            MPI_Aint displs[2] = {offsetof(value_index, value), offsetof(value_index, index)};
+            MPI_Datatype types[2] = {mpi::mpi_type<T>(), MPI_INT64_T};
+            MPI_Datatype t, resized;
+            CHECK_MPI(MPI_Type_create_struct(2, lengths, displs, types, &t));
+            CHECK_MPI(MPI_Type_create_resized(t, 0, sizeof(value_index), &resized));
+            CHECK_MPI(MPI_Type_free(&t));
+            return commit_type(resized);
+        }();
+        return type;
+    }
+};
+
+namespace detail
+{
+
+template <typename T, bool Max>
+struct select_with_index
+{
+    static value_index<T> combine(const value_index<T> &a, const value_index<T> &b)
+    {
+        bool take_b = Max ? (b.value > a.value) : (b.value < a.value);
+        take_b = take_b || (b.value == a.value && b.index < a.index);
+        return take_b ? b : a;
+    }
+
+    value_index<T> operator()(const value_index<T> &a, const value_index<T> &b) const { return combine(a, b); }
+    void operator()(const value_index<T> *MPICPP_RESTRICT in, value_index<T> *MPICPP_RESTRICT inout,
+                    std::size_t n) const
+    {
+        MPICPP_VECTORIZE
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const value_index<T> &a = in[i];
+            value_index<T> &b = inout[i];
+            bool take_a = Max ? (a.value > b.value) : (a.value < b.value);
+            take_a = take_a || (a.value == b.value && a.index < b.index);
+            b.value = take_a ? a.value : b.value;
+            b.index = take_a ? a.index : b.index;
+        }
+    }
+};
+
+} // end namespace detail
+
+template <typename T>
+using min_with_index = detail::select_with_index<T, false>;
+template <typename T>
+using max_with_index = detail::select_with_index<T, true>;
+
+} // end namespace mpi
+
+#endif // MPI_REDUCTION_HPP
@@ -0,0 +1,324 @@
+#pragma once
+#ifndef MPI_REORDER_HPP
+#define MPI_REORDER_HPP
+
+#include "communicator.hpp"
+#include "traffic.hpp"
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace mpi
+{
+
+// Records the bytes this rank sends to every rank of `comm` with send, isend, issend and sendrecv (also on
+// communicators dup()ed from `comm` while recording, e.g. by active_messages), from construction until stop(): run
+// the warm-up steps of the application in between. Collectives are not seen, add their traffic with record(). One
+// matrix records at a time, a second one sees nothing, and stop() must not race with sends on other threads.
+class communication_matrix
+{
+  private:
+    communicator m_comm;
+    std::unique_ptr<detail::traffic_log> m_log;
+    std::vector<std::uint64_t> m_bytes;
+
+  public:
+    explicit communication_matrix(const communicator &comm)
+        : m_comm(comm), m_log(std::make_unique<detail::traffic_log>(comm.data(), comm.size()))
+    {
+        detail::traffic_log *expected = nullptr;
+        [[maybe_unused]] bool started = detail::active_traffic().compare_exchange_strong(expected, m_log.get());
+        assert(started && "communication_matrix: another matrix is recording");
+    }
+    communication_matrix(const communication_matrix &) = delete;
+    communication_matrix &operator=(const communication_matrix &) = delete;
+    ~communication_matrix() { stop(); }
+
+    const communicator &comm() const { return m_comm; }
+    bool recording() const { return m_log != nullptr; }
+
+    void record(int dest, std::size_t bytes)
+    {
+        if (m_log)
+            m_log->bytes[dest].fetch_add(bytes, std::memory_order_relaxed);
+        else
+            m_bytes[dest] += bytes;
+    }
+
+    void stop()
+    {
+        if (!m_log)
+            return;
+        // a matrix which never got to record must not end the recording of another
+        detail::traffic_log *mine = m_log.get();
+        detail::active_traffic().compare_exchange_strong(mine, nullptr);
+        m_bytes.resize(m_log->size);
+        for (int r = 0; r < m_log->size; ++r)
+        {
+            m_bytes[r] = m_log->bytes[r];
+        }
+        m_log.reset();
+    }
+
+    // bytes this rank sent to every rank, stops the recording
+    const std::vector<std::uint64_t> &bytes_sent()
+    {
+        stop();
+        return m_bytes;
+    }
+
+    // collective, stops the recording: the whole matrix on every rank, row i holds the bytes rank i sent
+    std::vector<std::uint64_t> gather()
+    {
+        const std::size_t p = m_comm.size();
+        std::vector<std::uint64_t> matrix(p * p);
+        m_comm.allgather(bytes_sent().data(), matrix.data(), p);
+        return matrix;
+    }
+};
+
+enum class reorder_method
+{
+    none,  // the ranks keep their places
+    mpi,   // MPI_Dist_graph_create_adjacent with reorder
+    greedy // node-aware greedy mapping of this library
+};
+
+inline const char *to_string(reorder_method method)
+{
+    switch (method)
+    {
+        case reorder_method::none: return "none";
+        case reorder_method::mpi: return "mpi";
+        case reorder_method::greedy: return "greedy";
+    }
+    return "unknown";
+}
+
+struct reorder_options
+{
+    // ask MPI for a placement first, many libraries keep the ranks as they are
+    bool use_mpi = true;
+    // then place heavy talkers on the same node ourselves
+    bool greedy = true;
+    // ranks per node (consecutive ranks share a node), 0 asks MPI which ranks share memory
+    int ranks_per_node = 0;
+};
+
+struct rank_reordering
+{
+    // rank r of comm takes over the work of rank r of the original communicator, free() it when done
+    communicator comm{MPI_COMM_NULL};
+    reorder_method method = reorder_method::none;
+    // process[r]: the original rank of the process which has rank r in comm
+    std::vector<int> process;
+    std::uint64_t total_bytes = 0;
+    // recorded bytes between ranks on different nodes, with the original and the new placement
+    std::uint64_t inter_node_bytes_before = 0;
+    std::uint64_t inter_node_bytes_after = 0;
+};
+
+namespace detail
+{
+
+// node[r]: the node of rank r, numbered by the lowest rank on it
+inline std::vector<int> node_of_ranks(const communicator &comm, int ranks_per_node)
+{
+    const int p = comm.size();
+    std::vector<int> node(p);
+    if (ranks_per_node > 0)
+    {
+        for (int r = 0; r < p; ++r)
+        {
+            node[r] = r / ranks_per_node * ranks_per_node;
+        }
+        return node;
+    }
+    communicator shared = comm.split_shared();
+    int leader = comm.rank();
+    shared.broadcast(leader, 0);
+    shared.free();
+    comm.allgather(leader, node.data());
+    return node;
+}
+
+// bytes between tasks on different nodes when task t runs on process[t]
+inline std::uint64_t inter_node_bytes(const std::vector<std::uint64_t> &matrix, const std::vector<int> &node,
+                                      const std::vector<int> &process)
+{
+    const std::size_t p = process.size();
+    std::uint64_t bytes = 0;
+    for (std::size_t i = 0; i < p; ++i)
+    {
+        for (std::size_t j = 0; j < p; ++j)
+        {
+            if (node[process[i]] != node[process[j]])
+                bytes += matrix[i * p + j];
+        }
+    }
+    return bytes;
+}
+
+// Fills the nodes one after another: the unplaced task with the most traffic seeds a node, then the unplaced task
+// which talks most with the tasks already there joins until the node is full. O(p^2), the same on every rank.
+inline std::vector<int> greedy_placement(const std::vector<std::uint64_t> &matrix, const std::vector<int> &node)
+{
+    const std::size_t p = node.size();
+    std::vector<std::uint64_t> total(p, 0);
+    auto weight = [&](std::size_t i, std::size_t j) { return matrix[i * p + j] + matrix[j * p + i]; };
+    for (std::size_t i = 0; i < p; ++i)
+    {
+        for (std::size_t j = 0; j < p; ++j)
+        {
+            total[i] += weight(i, j);
+        }
+    }
+    // the processes of every node, in order of the nodes' lowest ranks
+    std::vector<std::vector<int>> slots;
+    std::vector<int> node_index(p, -1);
+    for (std::size_t r = 0; r < p; ++r)
+    {
+        if (node_index[node[r]] < 0)
+        {
+            node_index[node[r]] = static_cast<int>(slots.size());
+            slots.emplace_back();
+        }
+        slots[node_index[node[r]]].push_back(static_cast<int>(r));
+    }
+
+    std::vector<int> process(p, -1);
+    std::vector<bool> placed(p, false);
+    std::vector<std::uint64_t> affinity(p);
+    for (const auto &procs : slots)
+    {
+        std::fill(affinity.begin(), affinity.end(), 0);
+        std::vector<int> tasks;
+        while (tasks.size() < procs.size())
+        {
+            std::size_t best = p;
+            for (std::size_t t = 0; t < p; ++t)
+            {
+                if (placed[t])
+                    continue;
+                if (best == p || affinity[t] > affinity[best] ||
+                    (affinity[t] == affinity[best] && total[t] > total[best]))
+                    best = t;
+            }
+            placed[best] = true;
+            tasks.push_back(static_cast<int>(best));
+            for (std::size_t t = 0; t < p; ++t)
+            {
+                affinity[t] += weight(best, t);
+            }
+        }
+        std::sort(tasks.begin(), tasks.end());
+        for (std::size_t k = 0; k < tasks.size(); ++k)
+        {
+            process[tasks[k]] = procs[k];
+        }
+    }
+    return process;
+}
+
+} // end namespace detail
+
+// Collective over traffic.comm(), stops the recording. Builds a communicator in which heavy talkers share a node:
+// first MPI_Dist_graph_create_adjacent with the recorded bytes as edge weights and reorder = 1 (the result is a
+// graph communicator, usable for neighbourhood collectives), and if MPI's placement does not reduce the inter-node
+// bytes, the greedy node-aware placement above through MPI_Comm_split. If neither does, the result is a dup() of the
+// original communicator.
+inline rank_reordering reorder_ranks(communication_matrix &traffic, reorder_options options = {})
+{
+    const communicator &comm = traffic.comm();
+    const int p = comm.size(), rank = comm.rank();
+    auto matrix = traffic.gather();
+    auto node = detail::node_of_ranks(comm, options.ranks_per_node);
+
+    rank_reordering result;
+    std::vector<int> identity(p);
+    for (int r = 0; r < p; ++r)
+    {
+        identity[r] = r;
+    }
+    for (auto b : matrix)
+    {
+        result.total_bytes += b;
+    }
+    result.inter_node_bytes_before = detail::inter_node_bytes(matrix, node, identity);
+
+    if (options.use_mpi)
+    {
+        // MPI weights are ints: scale the bytes so the largest fits, a non-zero edge keeps at least weight 1
+        std::uint64_t largest = matrix.empty() ? 0 : *std::max_element(matrix.begin(), matrix.end());
+        int shift = 0;
+        while ((largest >> shift) > static_cast<std::uint64_t>(INT_MAX))
+        {
+            ++shift;
+        }
+        auto weight = [&](std::uint64_t bytes) { return static_cast<int>(std::max<std::uint64_t>(1, bytes >> shift)); };
+        std::vector<int> sources, source_weights, destinations, destination_weights;
+        for (int r = 0; r < p; ++r)
+        {
+            if (std::uint64_t in = matrix[static_cast<std::size_t>(r) * p + rank]; in > 0 && r != rank)
+            {
+                sources.push_back(r);
+                source_weights.push_back(weight(in));
+            }
+            if (std::uint64_t out = matrix[static_cast<std::size_t>(rank) * p + r]; out > 0 && r != rank)
+            {
+                destinations.push_back(r);
+                destination_weights.push_back(weight(out));
+            }
+        }
+        // a side without edges takes MPI_WEIGHTS_EMPTY, the data() of an empty vector may be null
+        auto weights = [](std::vector<int> &w) { return w.empty() ? MPI_WEIGHTS_EMPTY : w.data(); };
+        MPI_Comm graph;
+        CHECK_MPI(MPI_Dist_graph_create_adjacent(comm.data(), static_cast<int>(sources.size()), sources.data(),
+                                                 weights(source_weights), static_cast<int>(destinations.size()),
+                                                 destinations.data(), weights(destination_weights), MPI_INFO_NULL, 1,
+                                                 &graph));
+        communicator graph_comm{graph};
+        result.process.resize(p);
+        graph_comm.allgather(rank, result.process.data());
+        std::uint64_t after = detail::inter_node_bytes(matrix, node, result.process);
+        if (after < result.inter_node_bytes_before)
+        {
+            result.comm = graph_comm;
+            result.method = reorder_method::mpi;
+            result.inter_node_bytes_after = after;
+            return result;
+        }
+        graph_comm.free();
+    }
+
+    if (options.greedy)
+    {
+        auto process = detail::greedy_placement(matrix, node);
+        std::uint64_t after = detail::inter_node_bytes(matrix, node, process);
+        if (after < result.inter_node_bytes_before)
+        {
+            std::vector<int> task(p);
+            for (int t = 0; t < p; ++t)
+            {
+                task[process[t]] = t;
+            }
+            result.comm = comm.split(0, task[rank]);
+            result.method = reorder_method::greedy;
+            result.process = process;
+            result.inter_node_bytes_after = after;
+            return result;
+        }
+    }
+
+    result.comm = comm.dup();
+    result.process = identity;
+    result.inter_node_bytes_after = result.inter_node_bytes_before;
+    return result;
+}
+
+} // end namespace mpi
+
+#endif // MPI_REORDER_HPP
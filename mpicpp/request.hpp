@@ -4,6 +4,7 @@
 
 #include "error.hpp"
 #include "status.hpp"
+#include "tracking.hpp"
 #include <vector>
 
 namespace mpi
@@ -17,25 +18,46 @@ class request
   public:
     request() : m_request(MPI_REQUEST_NULL) {}
     request(MPI_Request request) : m_request(request) {}
+    // the destructor waits, so a request has a single owner.
+    request(const request &) = delete;
+    request &operator=(const request &) = delete;
+    request(request &&other) noexcept : m_request(other.m_request) { other.m_request = MPI_REQUEST_NULL; }
+    // waits for the request it replaces, which may throw with MPICPP_ERROR_EXCEPTION
+    request &operator=(request &&other)
+    {
+        if (this != &other)
+        {
+            wait();
+            m_request = other.m_request;
+            other.m_request = MPI_REQUEST_NULL;
+        }
+        return *this;
+    }
     bool valid() const { return m_request != MPI_REQUEST_NULL; }
     void wait(status &st)
     {
         if (!valid())
             return;
+        detail::watch_requests watch(&m_request, 1, true);
         CHECK_MPI(MPI_Wait(&m_request, st.ptr()));
+        watch.done();
     }
     void wait()
     {
         if (!valid())
             return;
+        detail::watch_requests watch(&m_request, 1, true);
         CHECK_MPI(MPI_Wait(&m_request, MPI_STATUS_IGNORE));
+        watch.done();
     }
     bool test(status &st)
     {
         if (!valid())
             return true; // completed
         int flag;
+        detail::watch_requests watch(&m_request, 1, false);
         CHECK_MPI(MPI_Test(&m_request, &flag, st.ptr()));
+        watch.done();
         return flag;
     }
     bool test()
@@ -43,13 +65,16 @@ class request
         if (!valid())
             return true; // completed
         int flag;
+        detail::watch_requests watch(&m_request, 1, false);
         CHECK_MPI(MPI_Test(&m_request, &flag, MPI_STATUS_IGNORE));
+        watch.done();
         return flag;
     }
     void cancel()
     {
         if (!valid())
             return;
+        detail::watch_cancelled(m_request);
         CHECK_MPI(MPI_Cancel(&m_request));
         CHECK_MPI(MPI_Request_free(&m_request));
     }
@@ -60,14 +85,36 @@ inline void wait_all(std::size_t count, request *requests, status *statuses)
 {
     MPI_Request *req = reinterpret_cast<MPI_Request *>(requests);
     MPI_Status *st = reinterpret_cast<MPI_Status *>(statuses);
+    detail::watch_requests watch(req, count, true);
     CHECK_MPI(MPI_Waitall(count, req, st));
+    watch.done();
+}
+
+inline void wait_all(std::vector<request> &requests)
+{
+    MPI_Request *req = reinterpret_cast<MPI_Request *>(requests.data());
+    detail::watch_requests watch(req, requests.size(), true);
+    CHECK_MPI(MPI_Waitall(requests.size(), req, MPI_STATUSES_IGNORE));
+    watch.done();
+}
+
+inline bool test_all(std::vector<request> &requests)
+{
+    int flag;
+    MPI_Request *req = reinterpret_cast<MPI_Request *>(requests.data());
+    detail::watch_requests watch(req, requests.size(), false);
+    CHECK_MPI(MPI_Testall(requests.size(), req, &flag, MPI_STATUSES_IGNORE));
+    watch.done();
+    return flag;
 }
 
 inline int wait_any(std::size_t count, request *requests, status &st)
 {
     int index = {};
     MPI_Request *req = reinterpret_cast<MPI_Request *>(requests);
+    detail::watch_requests watch(req, count, true);
     CHECK_MPI(MPI_Waitany(count, req, &index, st.ptr()));
+    watch.done();
     return index;
 }
 
@@ -77,7 +124,9 @@ inline std::vector<int> wait_some(std::size_t count, request *requests, status *
     std::vector<int> indices(count);
     MPI_Request *req = reinterpret_cast<MPI_Request *>(requests);
     MPI_Status *st = reinterpret_cast<MPI_Status *>(statuses);
+    detail::watch_requests watch(req, count, true);
     CHECK_MPI(MPI_Waitsome(count, req, &outcount, indices.data(), st));
+    watch.done();
     indices.resize(outcount);
     return indices;
 }
@@ -0,0 +1,140 @@
+#pragma once
+#ifndef MPI_SERIALIZE_HPP
+#define MPI_SERIALIZE_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mpi
+{
+
+// Minimal binary serialization for messages whose layout is not fixed: trivially copyable values, std::string,
+// std::vector, std::pair and std::tuple of those. No versioning or endianness handling, both sides must be the same
+// program.
+
+class serializer
+{
+  private:
+    std::vector<std::byte> m_buffer;
+
+  public:
+    serializer() = default;
+    explicit serializer(std::vector<std::byte> buffer) : m_buffer(std::move(buffer)) { m_buffer.clear(); }
+
+    void write(const void *data, std::size_t size)
+    {
+        std::size_t old = m_buffer.size();
+        m_buffer.resize(old + size);
+        if (size > 0)
+            std::memcpy(m_buffer.data() + old, data, size);
+    }
+
+    template <typename T>
+    serializer &operator<<(const T &value)
+    {
+        if constexpr (std::is_trivially_copyable_v<T>)
+        {
+            write(&value, sizeof(T));
+        }
+        else if constexpr (requires { typename T::traits_type; })
+        {
+            *this << value.size();
+            write(value.data(), value.size() * sizeof(typename T::value_type));
+        }
+        else if constexpr (requires { typename T::allocator_type; })
+        {
+            *this << value.size();
+            if constexpr (std::is_trivially_copyable_v<typename T::value_type>)
+            {
+                write(value.data(), value.size() * sizeof(typename T::value_type));
+            }
+            else
+            {
+                for (const auto &item : value)
+                {
+                    *this << item;
+                }
+            }
+        }
+        else
+        {
+            std::apply([this](const auto &...items) { (*this << ... << items); }, value);
+        }
+        return *this;
+    }
+
+    const std::vector<std::byte> &buffer() const { return m_buffer; }
+    std::vector<std::byte> take() { return std::move(m_buffer); }
+    std::size_t size() const { return m_buffer.size(); }
+};
+
+class deserializer
+{
+  private:
+    const std::byte *m_ptr;
+    const std::byte *m_end;
+
+  public:
+    deserializer(const std::byte *data, std::size_t size) : m_ptr(data), m_end(data + size) {}
+    explicit deserializer(const std::vector<std::byte> &buffer) : deserializer(buffer.data(), buffer.size()) {}
+
+    void read(void *data, std::size_t size)
+    {
+        assert(m_ptr + size <= m_end && "deserializer: read past the end");
+        if (size > 0)
+            std::memcpy(data, m_ptr, size);
+        m_ptr += size;
+    }
+
+    template <typename T>
+    deserializer &operator>>(T &value)
+    {
+        if constexpr (std::is_trivially_copyable_v<T>)
+        {
+            read(&value, sizeof(T));
+        }
+        else if constexpr (requires { typename T::traits_type; } || requires { typename T::allocator_type; })
+        {
+            std::size_t size;
+            *this >> size;
+            value.resize(size);
+            if constexpr (std::is_trivially_copyable_v<typename T::value_type>)
+            {
+                read(value.data(), size * sizeof(typename T::value_type));
+            }
+            else
+            {
+                for (auto &item : value)
+                {
+                    *this >> item;
+                }
+            }
+        }
+        else
+        {
+            std::apply([this](auto &...items) { (*this >> ... >> items); }, value);
+        }
+        return *this;
+    }
+
+    template <typename T>
+    T get()
+    {
+        T value;
+        *this >> value;
+        return value;
+    }
+
+    bool empty() const { return m_ptr == m_end; }
+    std::size_t remaining() const { return m_end - m_ptr; }
+};
+
+} // end namespace mpi
+
+#endif // MPI_SERIALIZE_HPP
@@ -0,0 +1,134 @@
+#pragma once
+#ifndef MPI_SORT_HPP
+#define MPI_SORT_HPP
+
+#include "communicator.hpp"
+#include "partition.hpp"
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace mpi
+{
+
+namespace detail
+{
+
+// merge the sorted runs [displs[i], displs[i] + counts[i]) of `runs` with a heap over the run heads.
+template <typename T, typename Compare>
+std::vector<T> kway_merge(std::vector<T> &runs, const std::vector<int> &counts, const std::vector<int> &displs,
+                          Compare comp)
+{
+    struct cursor
+    {
+        std::size_t pos;
+        std::size_t end;
+    };
+    auto greater = [&](const cursor &a, const cursor &b) { return comp(runs[b.pos], runs[a.pos]); };
+    std::priority_queue<cursor, std::vector<cursor>, decltype(greater)> heap(greater);
+    for (std::size_t i = 0; i < counts.size(); ++i)
+    {
+        if (counts[i] > 0)
+        {
+            heap.push(cursor{std::size_t(displs[i]), std::size_t(displs[i]) + counts[i]});
+        }
+    }
+    std::vector<T> merged;
+    merged.reserve(runs.size());
+    while (!heap.empty())
+    {
+        cursor c = heap.top();
+        heap.pop();
+        merged.push_back(std::move(runs[c.pos]));
+        if (++c.pos < c.end)
+        {
+            heap.push(c);
+        }
+    }
+    return merged;
+}
+
+} // end namespace detail
+
+// Parallel sample sort: after the call the concatenation of `data` over the ranks of `comm` (in rank order) is sorted.
+// Local sort, regular sampling gathered with allgatherv, p-1 splitters, one alltoallv exchange and a k-way merge of
+// the received runs. The local sizes are not balanced unless `rebalance` is set, which moves the result to the equal
+// block partition with one more allgather/alltoallv.
+template <typename T, typename Compare = std::less<T>>
+void sort(const communicator &comm, std::vector<T> &data, Compare comp = Compare{}, bool rebalance = false)
+{
+    std::sort(data.begin(), data.end(), comp);
+    const int p = comm.size();
+    if (p == 1)
+        return;
+
+    // regular sampling, empty ranks do not contribute samples.
+    const std::size_t n = data.size();
+    std::vector<std::size_t> sizes(p);
+    comm.allgather(n, sizes.data());
+    std::vector<int> sample_counts(p), sample_displs(p, 0);
+    for (int r = 0; r < p; ++r)
+    {
+        sample_counts[r] = sizes[r] > 0 ? p - 1 : 0;
+        if (r > 0)
+            sample_displs[r] = sample_displs[r - 1] + sample_counts[r - 1];
+    }
+    const std::size_t num_samples = sample_displs[p - 1] + sample_counts[p - 1];
+    if (num_samples == 0)
+        return;
+    std::vector<T> local_samples;
+    if (n > 0)
+    {
+        local_samples.reserve(p - 1);
+        for (int i = 1; i < p; ++i)
+        {
+            local_samples.push_back(data[i * n / p]);
+        }
+    }
+    std::vector<T> samples(num_samples);
+    comm.allgatherv(local_samples.data(), local_samples.size(), samples.data(), sample_counts.data(),
+                    sample_displs.data());
+    std::sort(samples.begin(), samples.end(), comp);
+
+    // bucket r gets the keys in (splitter[r-1], splitter[r]]
+    std::vector<int> send_counts(p), send_displs(p, 0);
+    auto first = data.begin();
+    for (int r = 0; r < p - 1; ++r)
+    {
+        const T &splitter = samples[(r + 1) * num_samples / p];
+        auto last = std::upper_bound(first, data.end(), splitter, comp);
+        send_counts[r] = static_cast<int>(last - first);
+        first = last;
+    }
+    send_counts[p - 1] = static_cast<int>(data.end() - first);
+    for (int r = 1; r < p; ++r)
+    {
+        send_displs[r] = send_displs[r - 1] + send_counts[r - 1];
+    }
+
+    std::vector<int> recv_counts(p), recv_displs(p, 0);
+    comm.alltoall(send_counts.data(), recv_counts.data());
+    for (int r = 1; r < p; ++r)
+    {
+        recv_displs[r] = recv_displs[r - 1] + recv_counts[r - 1];
+    }
+    std::vector<T> received(recv_displs[p - 1] + recv_counts[p - 1]);
+    comm.alltoallv(data.data(), send_counts.data(), send_displs.data(), received.data(), recv_counts.data(),
+                   recv_displs.data());
+    data = detail::kway_merge(received, recv_counts, recv_displs, comp);
+
+    if (rebalance)
+    {
+        std::size_t total = 0;
+        for (auto s : sizes)
+        {
+            total += s;
+        }
+        redistribute(comm, data, block_partition(total, p));
+    }
+}
+
+} // end namespace mpi
+
+#endif // MPI_SORT_HPP
@@ -26,6 +26,14 @@ class status
         CHECK_MPI(MPI_Get_count(&m_status, mpi_type<T>(), &count));
         return count;
     }
+    // get_count for messages of more than INT_MAX elements
+    template <typename T>
+    std::size_t get_count_x() const
+    {
+        MPI_Count bytes;
+        CHECK_MPI(MPI_Get_elements_x(&m_status, MPI_BYTE, &bytes));
+        return static_cast<std::size_t>(bytes) / sizeof(T);
+    }
     MPI_Status *ptr() { return &m_status; }
 };
 
@@ -0,0 +1,235 @@
+#pragma once
+#ifndef MPI_TASK_POOL_HPP
+#define MPI_TASK_POOL_HPP
+
+#include "communicator.hpp"
+#include "memory.hpp"
+#include "request.hpp"
+#include "serialize.hpp"
+#include "status.hpp"
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace mpi
+{
+
+// Distributed work stealing for irregular workloads. Every rank runs its own tasks from a local deque (newest
+// first); a rank which runs dry asks a random victim, which answers with the older half of its deque. Tasks are
+// serialized (see serialize.hpp) and may spawn new tasks through push(). Termination is detected with Dijkstra's
+// token ring: the token only passes idle ranks, and a rank which gave tasks away colours it dirty.
+// All messages use a duplicate of the given communicator.
+template <typename Task>
+class task_pool
+{
+  public:
+    using executor_type = std::function<void(Task &task, task_pool &pool)>;
+
+    struct statistics
+    {
+        std::size_t tasks_executed = 0;
+        std::size_t steal_attempts = 0;
+        std::size_t steal_successes = 0;
+        std::size_t tasks_stolen = 0; // received from victims
+        std::size_t tasks_given = 0;  // sent to thieves
+    };
+
+  private:
+    enum tags
+    {
+        steal_request_tag = 1,
+        steal_reply_tag,
+        token_tag,
+        done_tag
+    };
+
+    communicator m_comm;
+    executor_type m_execute;
+    std::deque<Task> m_tasks;
+    std::mt19937 m_rng;
+    statistics m_stats;
+
+    bool m_outstanding = false; // a steal request waits for its reply
+    bool m_done = false;
+    bool m_has_token = false;
+    bool m_token_dirty = false;
+    bool m_token_returned = false; // rank 0: the token went around the ring
+    bool m_dirty = false;          // gave tasks away since the token last passed
+    struct in_flight
+    {
+        std::vector<std::byte> data;
+        request req;
+    };
+    std::vector<in_flight> m_sending;
+
+  public:
+    // collective over `comm`
+    task_pool(const communicator &comm, executor_type execute)
+        : m_comm(comm.dup()), m_execute(std::move(execute)), m_rng(std::random_device{}() + comm.rank())
+    {
+    }
+    task_pool(const task_pool &) = delete;
+    task_pool &operator=(const task_pool &) = delete;
+    ~task_pool() { m_comm.free(); }
+
+    void push(Task task) { m_tasks.push_back(std::move(task)); }
+    std::size_t local_size() const { return m_tasks.size(); }
+    const statistics &stats() const { return m_stats; }
+
+    // Collective: runs until every task on every rank (including spawned ones) has been executed.
+    void run()
+    {
+        const int p = m_comm.size();
+        m_done = false;
+        m_has_token = m_comm.rank() == 0;
+        m_token_dirty = false;
+        m_token_returned = false;
+        m_dirty = false;
+        while (!m_done)
+        {
+            service();
+            if (!m_tasks.empty())
+            {
+                Task task = std::move(m_tasks.back());
+                m_tasks.pop_back();
+                m_execute(task, *this);
+                ++m_stats.tasks_executed;
+                continue;
+            }
+            if (p == 1)
+                break;
+            if (m_outstanding)
+                continue;
+            if (m_has_token)
+                pass_token();
+            if (!m_done)
+                steal();
+        }
+        // nobody steals after done, but requests already sent must be answered before leaving.
+        while (m_outstanding)
+        {
+            service();
+        }
+        request barrier = m_comm.ibarrier();
+        while (!barrier.test())
+        {
+            service();
+        }
+        m_sending.clear(); // waits
+    }
+
+  private:
+    void send(std::vector<std::byte> data, int dest, int tag)
+    {
+        const std::byte *ptr = data.data();
+        std::size_t size = data.size();
+        m_sending.push_back(in_flight{std::move(data), m_comm.isend(ptr, size, dest, tag)});
+    }
+
+    void steal()
+    {
+        std::uniform_int_distribution<int> pick(0, m_comm.size() - 2);
+        int victim = pick(m_rng);
+        if (victim >= m_comm.rank())
+            ++victim;
+        send({}, victim, steal_request_tag);
+        m_outstanding = true;
+        ++m_stats.steal_attempts;
+    }
+
+    void pass_token()
+    {
+        const int next = (m_comm.rank() + 1) % m_comm.size();
+        if (m_comm.rank() == 0)
+        {
+            if (m_token_returned && !m_token_dirty && !m_dirty)
+            {
+                for (int r = 1; r < m_comm.size(); ++r)
+                {
+                    send({}, r, done_tag);
+                }
+                m_done = true;
+                return;
+            }
+            m_token_dirty = false;
+        }
+        serializer out;
+        out << (m_token_dirty || m_dirty);
+        send(out.take(), next, token_tag);
+        m_has_token = false;
+        m_dirty = false;
+    }
+
+    void service()
+    {
+        status st;
+        while (m_comm.iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, st))
+        {
+            buffer<std::byte> message(st.get_count<std::byte>());
+            m_comm.recv(message.data(), message.size(), st.source(), st.tag());
+            deserializer in(message.data(), message.size());
+            switch (st.tag())
+            {
+                case steal_request_tag: answer(st.source()); break;
+                case steal_reply_tag:
+                {
+                    auto stolen = in.get<std::vector<Task>>();
+                    m_outstanding = false;
+                    if (!stolen.empty())
+                        ++m_stats.steal_successes;
+                    m_stats.tasks_stolen += stolen.size();
+                    for (auto &task : stolen)
+                    {
+                        m_tasks.push_back(std::move(task));
+                    }
+                    break;
+                }
+                case token_tag:
+                    m_token_dirty = in.get<bool>();
+                    m_has_token = true;
+                    m_token_returned = m_comm.rank() == 0;
+                    break;
+                case done_tag: m_done = true; break;
+            }
+        }
+        for (std::size_t i = 0; i < m_sending.size();)
+        {
+            if (m_sending[i].req.test())
+            {
+                m_sending[i] = std::move(m_sending.back());
+                m_sending.pop_back();
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+    // give the older half of the deque
+    void answer(int thief)
+    {
+        std::vector<Task> given;
+        std::size_t n = m_done ? 0 : m_tasks.size() / 2;
+        given.reserve(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            given.push_back(std::move(m_tasks.front()));
+            m_tasks.pop_front();
+        }
+        if (n > 0)
+        {
+            m_dirty = true;
+            m_stats.tasks_given += n;
+        }
+        serializer out;
+        out << given;
+        send(out.take(), thief, steal_reply_tag);
+    }
+};
+
+} // end namespace mpi
+
+#endif // MPI_TASK_POOL_HPP
@@ -0,0 +1,46 @@
+#pragma once
+#ifndef MPI_THREADS_HPP
+#define MPI_THREADS_HPP
+
+#include "communicator.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace mpi
+{
+
+// One duplicate of a communicator per thread. Under MPI_THREAD_MULTIPLE, threads sharing a communicator contend for
+// its matching queue and must tell their messages apart by tag; with a communicator each, thread i only matches
+// messages of thread i on the other ranks, and may also run collectives concurrently with the other threads.
+class thread_communicators
+{
+  private:
+    std::vector<communicator> m_comms;
+
+  public:
+    // collective over `comm`, every rank must ask for the same number of threads.
+    thread_communicators(const communicator &comm, int threads)
+    {
+        m_comms.reserve(threads);
+        for (int i = 0; i < threads; ++i)
+        {
+            m_comms.push_back(comm.dup());
+        }
+    }
+    thread_communicators(const thread_communicators &) = delete;
+    thread_communicators &operator=(const thread_communicators &) = delete;
+    ~thread_communicators()
+    {
+        for (auto &comm : m_comms)
+        {
+            comm.free();
+        }
+    }
+
+    int size() const { return static_cast<int>(m_comms.size()); }
+    const communicator &operator[](int thread) const { return m_comms[thread]; }
+};
+
+} // end namespace mpi
+
+#endif // MPI_THREADS_HPP
@@ -0,0 +1,279 @@
+#pragma once
+#ifndef MPI_TIMER_HPP
+#define MPI_TIMER_HPP
+
+#include "communicator.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace mpi
+{
+
+// Named, nested region timers. Each rank accumulates the time and the number of entries of every region path
+// ("solve/halo" is halo entered inside solve), and timer_report() reduces the totals across a communicator. Entering a
+// region costs a clock read and a compare with each sibling name, so names may be built at runtime.
+// The registry is not thread-safe: time regions on one thread per rank.
+class timer_registry
+{
+  private:
+    struct region
+    {
+        std::string name;
+        int parent;
+        std::vector<int> children;
+        double seconds = 0;
+        std::uint64_t calls = 0;
+    };
+    std::vector<region> m_regions;
+    int m_current = 0;
+
+    timer_registry() { m_regions.push_back({"", -1, {}}); }
+
+  public:
+    timer_registry(const timer_registry &) = delete;
+    timer_registry &operator=(const timer_registry &) = delete;
+
+    static timer_registry &instance()
+    {
+        static timer_registry registry;
+        return registry;
+    }
+
+    // makes the child `name` of the current region current, returns its index
+    int enter(const char *name)
+    {
+        for (int child : m_regions[m_current].children)
+        {
+            if (m_regions[child].name == name)
+                return m_current = child;
+        }
+        int index = static_cast<int>(m_regions.size());
+        m_regions.push_back({name, m_current, {}});
+        m_regions[m_current].children.push_back(index);
+        return m_current = index;
+    }
+
+    void leave(int index, double seconds)
+    {
+        auto &r = m_regions[index];
+        r.seconds += seconds;
+        ++r.calls;
+        m_current = r.parent;
+    }
+
+    // drops all regions, only outside of every region
+    void reset()
+    {
+        m_regions.resize(1);
+        m_regions[0].children.clear();
+        m_current = 0;
+    }
+
+    // path -> (seconds, calls) of every region entered on this rank
+    std::map<std::string, std::pair<double, std::uint64_t>> totals() const
+    {
+        std::map<std::string, std::pair<double, std::uint64_t>> result;
+        for (std::size_t i = 1; i < m_regions.size(); ++i)
+        {
+            result[path(static_cast<int>(i))] = {m_regions[i].seconds, m_regions[i].calls};
+        }
+        return result;
+    }
+
+  private:
+    std::string path(int index) const
+    {
+        std::string p = m_regions[index].name;
+        for (int i = m_regions[index].parent; i > 0; i = m_regions[i].parent)
+        {
+            p = m_regions[i].name + '/' + p;
+        }
+        return p;
+    }
+};
+
+// Times its own lifetime as the region `name` nested in the enclosing scoped_timer, e.g.
+//     mpi::scoped_timer t("halo");
+class scoped_timer
+{
+  private:
+    using clock = std::chrono::steady_clock;
+    int m_index;
+    clock::time_point m_start;
+
+  public:
+    explicit scoped_timer(const char *name)
+        : m_index(timer_registry::instance().enter(name)), m_start(clock::now())
+    {
+    }
+    scoped_timer(const scoped_timer &) = delete;
+    scoped_timer &operator=(const scoped_timer &) = delete;
+    ~scoped_timer()
+    {
+        std::chrono::duration<double> elapsed = clock::now() - m_start;
+        timer_registry::instance().leave(m_index, elapsed.count());
+    }
+};
+
+// one region across the ranks of a communicator, ranks which never entered it count as 0 seconds
+struct region_stats
+{
+    std::string name;    // full path
+    int depth;           // 0 for outermost regions
+    std::uint64_t calls; // summed over ranks
+    double min;
+    double max;
+    double mean;
+    double imbalance;    // max / mean, 1 when balanced
+};
+
+namespace detail
+{
+
+inline std::vector<std::string> split_path(const std::string &path)
+{
+    std::vector<std::string> parts;
+    std::size_t begin = 0;
+    for (std::size_t end; (end = path.find('/', begin)) != std::string::npos; begin = end + 1)
+    {
+        parts.push_back(path.substr(begin, end - begin));
+    }
+    parts.push_back(path.substr(begin));
+    return parts;
+}
+
+// parents before their children, siblings by name
+inline bool region_order(const std::string &a, const std::string &b) { return split_path(a) < split_path(b); }
+
+inline std::string json_escape(const std::string &s)
+{
+    std::string out;
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+} // end namespace detail
+
+// collective: the statistics of every region entered on any rank of `comm`, the same on all ranks.
+inline std::vector<region_stats> timer_report(const communicator &comm = world)
+{
+    auto local = timer_registry::instance().totals();
+    // the union of the region names
+    std::string names;
+    for (const auto &[name, value] : local)
+    {
+        names += name + '\n';
+    }
+    const int p = comm.size();
+    std::vector<int> lengths(p), displs(p);
+    comm.allgather(static_cast<int>(names.size()), lengths.data());
+    for (int r = 1; r < p; ++r)
+    {
+        displs[r] = displs[r - 1] + lengths[r - 1];
+    }
+    std::string all(displs.back() + lengths.back(), '\0');
+    comm.allgatherv(names.data(), names.size(), all.data(), lengths.data(), displs.data());
+    std::vector<std::string> regions;
+    std::istringstream iss(all);
+    for (std::string line; std::getline(iss, line);)
+    {
+        regions.push_back(line);
+    }
+    std::sort(regions.begin(), regions.end(), detail::region_order);
+    regions.erase(std::unique(regions.begin(), regions.end()), regions.end());
+
+    const std::size_t n = regions.size();
+    std::vector<double> seconds(n, 0), min(n), max(n), sum(n);
+    std::vector<std::uint64_t> calls(n, 0), total_calls(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (auto it = local.find(regions[i]); it != local.end())
+        {
+            seconds[i] = it->second.first;
+            calls[i] = it->second.second;
+        }
+    }
+    comm.allreduce(seconds.data(), min.data(), n, op::min());
+    comm.allreduce(seconds.data(), max.data(), n, op::max());
+    comm.allreduce(seconds.data(), sum.data(), n, op::sum());
+    comm.allreduce(calls.data(), total_calls.data(), n, op::sum());
+
+    std::vector<region_stats> report;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        double mean = sum[i] / p;
+        int depth = static_cast<int>(std::count(regions[i].begin(), regions[i].end(), '/'));
+        report.push_back({regions[i], depth, total_calls[i], min[i], max[i], mean, mean > 0 ? max[i] / mean : 1.0});
+    }
+    return report;
+}
+
+inline std::string timer_report_json(const std::vector<region_stats> &report, int ranks)
+{
+    std::ostringstream oss;
+    oss << std::setprecision(9) << "{\"ranks\": " << ranks << ", \"regions\": [";
+    for (std::size_t i = 0; i < report.size(); ++i)
+    {
+        const auto &r = report[i];
+        oss << (i ? ",\n  " : "\n  ") << "{\"name\": \"" << detail::json_escape(r.name) << "\", \"depth\": " << r.depth
+            << ", \"calls\": " << r.calls << ", \"min\": " << r.min << ", \"max\": " << r.max
+            << ", \"mean\": " << r.mean << ", \"imbalance\": " << r.imbalance << '}';
+    }
+    oss << "\n]}\n";
+    return oss.str();
+}
+
+// collective: rank 0 logs one line per region, nested regions indented.
+inline void log_timers(const communicator &comm = world)
+{
+    auto report = timer_report(comm);
+    if (comm.rank() != 0)
+        return;
+    std::size_t width = 6;
+    for (const auto &r : report)
+    {
+        width = std::max(width, 2 * r.depth + detail::split_path(r.name).back().size());
+    }
+    std::ostringstream header;
+    header << std::left << std::setw(width) << "region" << std::right << std::setw(10) << "calls" << std::setw(12)
+           << "min [s]" << std::setw(12) << "max [s]" << std::setw(12) << "mean [s]" << std::setw(10) << "imbalance";
+    log_info(header.str());
+    for (const auto &r : report)
+    {
+        std::ostringstream line;
+        line << std::left << std::setw(width) << std::string(2 * r.depth, ' ') + detail::split_path(r.name).back()
+             << std::right << std::setw(10) << r.calls << std::fixed << std::setprecision(6) << std::setw(12) << r.min
+             << std::setw(12) << r.max << std::setw(12) << r.mean << std::setprecision(3) << std::setw(10)
+             << r.imbalance;
+        log_info(line.str());
+    }
+}
+
+// collective: rank 0 writes the report as JSON to `path`, false (on rank 0) if the file cannot be written.
+inline bool write_timers_json(const std::string &path, const communicator &comm = world)
+{
+    auto report = timer_report(comm);
+    if (comm.rank() != 0)
+        return true;
+    std::ofstream file(path);
+    file << timer_report_json(report, comm.size());
+    return static_cast<bool>(file);
+}
+
+} // end namespace mpi
+
+#endif // MPI_TIMER_HPP
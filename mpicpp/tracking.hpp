@@ -0,0 +1,318 @@
+#pragma once
+#ifndef MPI_TRACKING_HPP
+#define MPI_TRACKING_HPP
+
+#include "error.hpp"
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace mpi
+{
+
+// Operation tracking for the stall watchdog (watchdog.hpp). Compiled in only with MPICPP_WATCHDOG defined: then the
+// communicator registers every point-to-point operation and barrier with its peer, tag, size and start time, the
+// request functions report the completions, and the completion latencies go into one histogram per operation. Without
+// the define the hooks are empty and cost nothing.
+#ifdef MPICPP_WATCHDOG
+inline constexpr bool tracking_enabled = true;
+#else
+inline constexpr bool tracking_enabled = false;
+#endif
+
+enum class operation
+{
+    send,
+    recv,
+    sendrecv,
+    probe,
+    barrier,
+    isend,
+    irecv
+};
+inline constexpr std::size_t operation_count = 7;
+
+inline const char *to_string(operation kind)
+{
+    switch (kind)
+    {
+        case operation::send: return "send";
+        case operation::recv: return "recv";
+        case operation::sendrecv: return "sendrecv";
+        case operation::probe: return "probe";
+        case operation::barrier: return "barrier";
+        case operation::isend: return "isend";
+        case operation::irecv: return "irecv";
+    }
+    return "unknown";
+}
+
+struct tracked_operation
+{
+    operation kind;
+    int peer; // MPI_ANY_SOURCE or MPI_PROC_NULL possible, -1 for barrier
+    int tag;
+    std::size_t bytes;
+    std::chrono::steady_clock::time_point start;
+    bool waiting; // a thread blocks in MPI for it (always for blocking operations)
+
+    double age() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); }
+};
+
+// Completion latencies in power-of-two buckets of microseconds: bucket 0 is below 1 us, bucket b in [2^(b-1), 2^b) us.
+class latency_histogram
+{
+  public:
+    static constexpr std::size_t buckets = 40;
+
+  private:
+    std::array<std::uint64_t, buckets> m_counts{};
+
+  public:
+    void add(double seconds)
+    {
+        double us = seconds * 1e6;
+        std::size_t b = us < 1 ? 0 : std::min<std::size_t>(buckets - 1, static_cast<std::size_t>(std::log2(us)) + 1);
+        ++m_counts[b];
+    }
+    void merge(const latency_histogram &other)
+    {
+        for (std::size_t b = 0; b < buckets; ++b)
+        {
+            m_counts[b] += other.m_counts[b];
+        }
+    }
+    std::uint64_t operator[](std::size_t b) const { return m_counts[b]; }
+    std::uint64_t *data() { return m_counts.data(); }
+    const std::uint64_t *data() const { return m_counts.data(); }
+    std::uint64_t count() const
+    {
+        std::uint64_t n = 0;
+        for (auto c : m_counts)
+        {
+            n += c;
+        }
+        return n;
+    }
+    // upper end of bucket b in seconds
+    static double upper_bound(std::size_t b) { return std::ldexp(1e-6, static_cast<int>(b)); }
+    // upper end of the bucket holding the q-quantile, 0 when empty
+    double quantile(double q) const
+    {
+        std::uint64_t n = count(), seen = 0;
+        if (n == 0)
+            return 0;
+        for (std::size_t b = 0; b < buckets; ++b)
+        {
+            seen += m_counts[b];
+            if (seen >= q * n)
+                return upper_bound(b);
+        }
+        return upper_bound(buckets - 1);
+    }
+};
+
+namespace detail
+{
+
+class operation_tracker
+{
+  private:
+    using clock = std::chrono::steady_clock;
+    mutable std::mutex m_mutex;
+    std::uint64_t m_next = 0;
+    std::map<std::uint64_t, tracked_operation> m_blocking;
+    std::map<MPI_Request, tracked_operation> m_pending;
+    std::array<latency_histogram, operation_count> m_histograms;
+
+    void finish(const tracked_operation &op)
+    {
+        m_histograms[static_cast<std::size_t>(op.kind)].add(op.age());
+    }
+
+  public:
+    static operation_tracker &instance()
+    {
+        static operation_tracker tracker;
+        return tracker;
+    }
+
+    std::uint64_t begin(operation kind, int peer, int tag, std::size_t bytes)
+    {
+        std::lock_guard lock(m_mutex);
+        m_blocking.emplace(m_next, tracked_operation{kind, peer, tag, bytes, clock::now(), true});
+        return m_next++;
+    }
+    void end(std::uint64_t id)
+    {
+        std::lock_guard lock(m_mutex);
+        auto it = m_blocking.find(id);
+        finish(it->second);
+        m_blocking.erase(it);
+    }
+
+    void started(MPI_Request req, operation kind, int peer, int tag, std::size_t bytes)
+    {
+        if (req == MPI_REQUEST_NULL)
+            return;
+        std::lock_guard lock(m_mutex);
+        m_pending.insert_or_assign(req, tracked_operation{kind, peer, tag, bytes, clock::now(), false});
+    }
+    void waiting(MPI_Request req, bool flag)
+    {
+        std::lock_guard lock(m_mutex);
+        if (auto it = m_pending.find(req); it != m_pending.end())
+            it->second.waiting = flag;
+    }
+    // `record` false drops the operation without a latency, e.g. when cancelled
+    void completed(MPI_Request req, bool record = true)
+    {
+        std::lock_guard lock(m_mutex);
+        if (auto it = m_pending.find(req); it != m_pending.end())
+        {
+            if (record)
+                finish(it->second);
+            m_pending.erase(it);
+        }
+    }
+
+    std::vector<tracked_operation> outstanding() const
+    {
+        std::lock_guard lock(m_mutex);
+        std::vector<tracked_operation> ops;
+        for (const auto &[id, op] : m_blocking)
+        {
+            ops.push_back(op);
+        }
+        for (const auto &[req, op] : m_pending)
+        {
+            ops.push_back(op);
+        }
+        return ops;
+    }
+    std::array<latency_histogram, operation_count> histograms() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_histograms;
+    }
+    void reset_histograms()
+    {
+        std::lock_guard lock(m_mutex);
+        m_histograms = {};
+    }
+};
+
+// ----- hooks, empty without MPICPP_WATCHDOG -----
+
+// bytes of one element of `type`, only computed when tracking
+inline std::size_t tracked_bytes([[maybe_unused]] MPI_Datatype type)
+{
+#ifdef MPICPP_WATCHDOG
+    int size;
+    CHECK_MPI(MPI_Type_size(type, &size));
+    return static_cast<std::size_t>(size);
+#else
+    return 0;
+#endif
+}
+
+// tracks a blocking operation for its lifetime
+class watch_blocking
+{
+#ifdef MPICPP_WATCHDOG
+  private:
+    std::uint64_t m_id;
+
+  public:
+    watch_blocking(operation kind, int peer, int tag, std::size_t bytes)
+        : m_id(operation_tracker::instance().begin(kind, peer, tag, bytes))
+    {
+    }
+    ~watch_blocking() { operation_tracker::instance().end(m_id); }
+#else
+  public:
+    watch_blocking(operation, int, int, std::size_t) {}
+#endif
+    watch_blocking(const watch_blocking &) = delete;
+    watch_blocking &operator=(const watch_blocking &) = delete;
+};
+
+inline void watch_started([[maybe_unused]] MPI_Request req, [[maybe_unused]] operation kind,
+                          [[maybe_unused]] int peer, [[maybe_unused]] int tag, [[maybe_unused]] std::size_t bytes)
+{
+#ifdef MPICPP_WATCHDOG
+    operation_tracker::instance().started(req, kind, peer, tag, bytes);
+#endif
+}
+
+inline void watch_cancelled([[maybe_unused]] MPI_Request req)
+{
+#ifdef MPICPP_WATCHDOG
+    operation_tracker::instance().completed(req, false);
+#endif
+}
+
+// The handles of `count` requests before a wait or test: done() reports the ones MPI has since set to
+// MPI_REQUEST_NULL as completed.
+class watch_requests
+{
+#ifdef MPICPP_WATCHDOG
+  private:
+    const MPI_Request *m_requests;
+    std::vector<MPI_Request> m_handles;
+    bool m_waiting;
+
+  public:
+    watch_requests(const MPI_Request *requests, std::size_t count, bool waiting)
+        : m_requests(requests), m_handles(requests, requests + count), m_waiting(waiting)
+    {
+        if (m_waiting)
+        {
+            for (auto req : m_handles)
+            {
+                operation_tracker::instance().waiting(req, true);
+            }
+        }
+    }
+    void done() const
+    {
+        for (std::size_t i = 0; i < m_handles.size(); ++i)
+        {
+            if (m_handles[i] == MPI_REQUEST_NULL)
+                continue;
+            if (m_requests[i] == MPI_REQUEST_NULL)
+                operation_tracker::instance().completed(m_handles[i]);
+            else if (m_waiting)
+                operation_tracker::instance().waiting(m_handles[i], false);
+        }
+    }
+#else
+  public:
+    watch_requests(const MPI_Request *, std::size_t, bool) {}
+    void done() const {}
+#endif
+};
+
+} // end namespace detail
+
+// the operations of this rank which have started and not completed, empty without MPICPP_WATCHDOG
+inline std::vector<tracked_operation> outstanding_operations()
+{
+    return detail::operation_tracker::instance().outstanding();
+}
+
+// this rank's completion latencies, indexed by operation
+inline std::array<latency_histogram, operation_count> latency_histograms()
+{
+    return detail::operation_tracker::instance().histograms();
+}
+
+inline void reset_latency_histograms() { detail::operation_tracker::instance().reset_histograms(); }
+
+} // end namespace mpi
+
+#endif // MPI_TRACKING_HPP
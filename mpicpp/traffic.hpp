@@ -0,0 +1,82 @@
+#pragma once
+#ifndef MPI_TRAFFIC_HPP
+#define MPI_TRAFFIC_HPP
+
+#include "error.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mpi
+{
+
+namespace detail
+{
+
+// The bytes sent to every rank of one communicator (and of the communicators dup()ed from it while recording) by
+// point-to-point sends, see communication_matrix in reorder.hpp. The communicator reports each send through
+// record_traffic(), which costs a relaxed atomic load when nothing records.
+struct traffic_log
+{
+    std::mutex mutex; // guards comms
+    std::vector<MPI_Comm> comms;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> bytes;
+    int size;
+
+    traffic_log(MPI_Comm comm, int size)
+        : comms{comm}, bytes(new std::atomic<std::uint64_t>[size]), size(size)
+    {
+        for (int r = 0; r < size; ++r)
+        {
+            bytes[r] = 0;
+        }
+    }
+    bool covers(MPI_Comm comm)
+    {
+        std::lock_guard lock(mutex);
+        return std::find(comms.begin(), comms.end(), comm) != comms.end();
+    }
+};
+
+inline std::atomic<traffic_log *> &active_traffic()
+{
+    static std::atomic<traffic_log *> log{nullptr};
+    return log;
+}
+
+inline void record_traffic(MPI_Comm comm, int dest, std::size_t bytes)
+{
+    traffic_log *log = active_traffic().load(std::memory_order_relaxed);
+    if (log && dest >= 0 && dest < log->size && log->covers(comm))
+        log->bytes[dest].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+// `count` elements of `type`, the size only looked up while recording
+inline void record_traffic(MPI_Comm comm, int dest, MPI_Datatype type, std::size_t count)
+{
+    if (!active_traffic().load(std::memory_order_relaxed))
+        return;
+    int size;
+    CHECK_MPI(MPI_Type_size(type, &size));
+    record_traffic(comm, dest, count * size);
+}
+
+// a communicator dup()ed from a recorded one is recorded as well, it has the same ranks
+inline void record_traffic_dup(MPI_Comm parent, MPI_Comm child)
+{
+    traffic_log *log = active_traffic().load(std::memory_order_relaxed);
+    if (log && log->covers(parent))
+    {
+        std::lock_guard lock(log->mutex);
+        log->comms.push_back(child);
+    }
+}
+
+} // end namespace detail
+
+} // end namespace mpi
+
+#endif // MPI_TRAFFIC_HPP
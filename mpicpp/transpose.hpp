@@ -0,0 +1,298 @@
+#pragma once
+#ifndef MPI_TRANSPOSE_HPP
+#define MPI_TRANSPOSE_HPP
+
+#include "communicator.hpp"
+#include "memory.hpp"
+#include "partition.hpp"
+#include "view.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <climits>
+#include <cstddef>
+#include <vector>
+
+namespace mpi
+{
+
+// ----- block decompositions -----
+
+// The index box [lo, hi) of an N-dimensional array. A rank stores its box row-major (the last dimension contiguous).
+template <std::size_t N>
+struct box
+{
+    std::array<std::size_t, N> lo{};
+    std::array<std::size_t, N> hi{};
+
+    std::size_t extent(std::size_t d) const { return hi[d] > lo[d] ? hi[d] - lo[d] : 0; }
+    std::size_t volume() const
+    {
+        std::size_t v = 1;
+        for (std::size_t d = 0; d < N; ++d)
+        {
+            v *= extent(d);
+        }
+        return v;
+    }
+    bool empty() const { return volume() == 0; }
+    box intersect(const box &other) const
+    {
+        box result;
+        for (std::size_t d = 0; d < N; ++d)
+        {
+            result.lo[d] = std::max(lo[d], other.lo[d]);
+            result.hi[d] = std::max(result.lo[d], std::min(hi[d], other.hi[d]));
+        }
+        return result;
+    }
+};
+
+// `shape` cut into `parts` slabs along dimension `dim`, one box per rank.
+template <std::size_t N>
+std::vector<box<N>> slab_decomposition(const std::array<std::size_t, N> &shape, int parts, std::size_t dim)
+{
+    block_partition split(shape[dim], parts);
+    std::vector<box<N>> boxes(parts);
+    for (int r = 0; r < parts; ++r)
+    {
+        boxes[r].hi = shape;
+        boxes[r].lo[dim] = split.begin(r);
+        boxes[r].hi[dim] = split.end(r);
+    }
+    return boxes;
+}
+
+// `shape` cut along dimensions dims[0] and dims[1] over a grid[0] x grid[1] process grid, rank i * grid[1] + j owns
+// block i of dims[0] and block j of dims[1]. The pencils run along the remaining dimension(s).
+template <std::size_t N>
+std::vector<box<N>> pencil_decomposition(const std::array<std::size_t, N> &shape, const std::array<int, 2> &grid,
+                                         const std::array<std::size_t, 2> &dims)
+{
+    block_partition first(shape[dims[0]], grid[0]), second(shape[dims[1]], grid[1]);
+    std::vector<box<N>> boxes(grid[0] * grid[1]);
+    for (int i = 0; i < grid[0]; ++i)
+    {
+        for (int j = 0; j < grid[1]; ++j)
+        {
+            auto &b = boxes[i * grid[1] + j];
+            b.hi = shape;
+            b.lo[dims[0]] = first.begin(i);
+            b.hi[dims[0]] = first.end(i);
+            b.lo[dims[1]] = second.begin(j);
+            b.hi[dims[1]] = second.end(j);
+        }
+    }
+    return boxes;
+}
+
+namespace detail
+{
+
+// f(offset, length) for every row (a run along the last dimension) of `part`, the offsets are into the row-major
+// storage of `whole`.
+template <std::size_t N, typename F>
+void for_each_row(const box<N> &whole, const box<N> &part, F f)
+{
+    if (part.empty())
+        return;
+    std::array<std::size_t, N> index = part.lo;
+    const std::size_t length = part.extent(N - 1);
+    while (true)
+    {
+        std::size_t offset = 0;
+        for (std::size_t d = 0; d < N; ++d)
+        {
+            offset = offset * whole.extent(d) + (index[d] - whole.lo[d]);
+        }
+        f(offset, length);
+        std::size_t d = N - 1;
+        while (true)
+        {
+            if (d == 0)
+                return;
+            --d;
+            if (++index[d] < part.hi[d])
+                break;
+            index[d] = part.lo[d];
+        }
+    }
+}
+
+// `part` of the row-major storage of `whole` as an MPI datatype
+template <typename T, std::size_t N>
+MPI_Datatype subarray_type(const box<N> &whole, const box<N> &part)
+{
+    std::array<int, N> sizes, subsizes, starts;
+    for (std::size_t d = 0; d < N; ++d)
+    {
+        assert(whole.extent(d) <= INT_MAX);
+        sizes[d] = static_cast<int>(whole.extent(d));
+        subsizes[d] = static_cast<int>(part.extent(d));
+        starts[d] = static_cast<int>(part.lo[d] - whole.lo[d]);
+    }
+    MPI_Datatype type;
+    CHECK_MPI(MPI_Type_create_subarray(static_cast<int>(N), sizes.data(), subsizes.data(), starts.data(), MPI_ORDER_C,
+                                       mpi_type<T>(), &type));
+    return type;
+}
+
+} // end namespace detail
+
+// ----- redistribution plan -----
+
+enum class redistribution_method
+{
+    automatic, // time both once when the plan is built, keep the faster
+    alltoallw, // one subarray datatype per peer, MPI moves the data in place
+    packed     // pack the rows per peer, alltoallv, unpack
+};
+
+// Moves an N-dimensional array from one block decomposition to another, e.g. the slab or pencil transposes of a
+// distributed FFT. `from` and `to` hold the box of every rank (the same on all ranks). The plan precomputes the
+// overlaps and datatypes once and is reused for every execute().
+template <typename T, std::size_t N>
+class redistribution_plan
+{
+  private:
+    communicator m_comm;
+    box<N> m_from;
+    box<N> m_to;
+    redistribution_method m_method;
+
+    // alltoallw: count 0 or 1 of a subarray datatype per peer
+    std::vector<int> m_send_types_count;
+    std::vector<int> m_recv_types_count;
+    std::vector<int> m_zero_displs;
+    std::vector<MPI_Datatype> m_send_types;
+    std::vector<MPI_Datatype> m_recv_types;
+    std::vector<detail::datatype_handle> m_types;
+
+    // packed: the overlap with every peer, and the alltoallv layout of the packed buffers
+    std::vector<box<N>> m_send_boxes;
+    std::vector<box<N>> m_recv_boxes;
+    std::vector<int> m_send_counts;
+    std::vector<int> m_send_displs;
+    std::vector<int> m_recv_counts;
+    std::vector<int> m_recv_displs;
+    buffer<T> m_send_buffer;
+    buffer<T> m_recv_buffer;
+
+  public:
+    // collective over `comm`
+    redistribution_plan(const communicator &comm, const std::vector<box<N>> &from, const std::vector<box<N>> &to,
+                        redistribution_method method = redistribution_method::automatic)
+        : m_comm(comm), m_from(from[comm.rank()]), m_to(to[comm.rank()]), m_method(method)
+    {
+        check_type<T>();
+        const int p = comm.size();
+        assert(static_cast<int>(from.size()) == p && static_cast<int>(to.size()) == p);
+        m_send_types_count.resize(p);
+        m_recv_types_count.resize(p);
+        m_zero_displs.assign(p, 0);
+        m_send_types.assign(p, mpi_type<T>());
+        m_recv_types.assign(p, mpi_type<T>());
+        m_send_counts.resize(p);
+        m_send_displs.resize(p);
+        m_recv_counts.resize(p);
+        m_recv_displs.resize(p);
+        std::size_t send_total = 0, recv_total = 0;
+        for (int r = 0; r < p; ++r)
+        {
+            m_send_boxes.push_back(m_from.intersect(to[r]));
+            m_recv_boxes.push_back(m_to.intersect(from[r]));
+            const box<N> &out = m_send_boxes.back(), &in = m_recv_boxes.back();
+            if (!out.empty())
+            {
+                m_types.emplace_back(detail::subarray_type<T>(m_from, out));
+                m_send_types[r] = m_types.back().get();
+                m_send_types_count[r] = 1;
+            }
+            if (!in.empty())
+            {
+                m_types.emplace_back(detail::subarray_type<T>(m_to, in));
+                m_recv_types[r] = m_types.back().get();
+                m_recv_types_count[r] = 1;
+            }
+            assert(send_total + out.volume() <= INT_MAX && recv_total + in.volume() <= INT_MAX);
+            m_send_counts[r] = static_cast<int>(out.volume());
+            m_send_displs[r] = static_cast<int>(send_total);
+            m_recv_counts[r] = static_cast<int>(in.volume());
+            m_recv_displs[r] = static_cast<int>(recv_total);
+            send_total += out.volume();
+            recv_total += in.volume();
+        }
+        if (m_method == redistribution_method::automatic)
+            m_method = choose();
+        if (m_method == redistribution_method::packed)
+        {
+            m_send_buffer.resize(send_total);
+            m_recv_buffer.resize(recv_total);
+        }
+    }
+
+    redistribution_method method() const { return m_method; }
+    // elements of the local block before and after
+    std::size_t source_size() const { return m_from.volume(); }
+    std::size_t target_size() const { return m_to.volume(); }
+
+    // collective: `src` holds the local box of `from`, `dst` receives the local box of `to`.
+    void execute(const T *src, T *dst) { execute(src, dst, m_method); }
+
+  private:
+    void execute(const T *src, T *dst, redistribution_method method)
+    {
+        if (method == redistribution_method::alltoallw)
+        {
+            m_comm.alltoallw(src, m_send_types_count.data(), m_zero_displs.data(), m_send_types.data(), dst,
+                             m_recv_types_count.data(), m_zero_displs.data(), m_recv_types.data());
+            return;
+        }
+        T *packed = m_send_buffer.data();
+        for (int r = 0; r < m_comm.size(); ++r)
+        {
+            detail::for_each_row(m_from, m_send_boxes[r], [&](std::size_t offset, std::size_t length) {
+                packed = std::copy(src + offset, src + offset + length, packed);
+            });
+        }
+        m_comm.alltoallv(m_send_buffer.data(), m_send_counts.data(), m_send_displs.data(), m_recv_buffer.data(),
+                         m_recv_counts.data(), m_recv_displs.data());
+        const T *unpacked = m_recv_buffer.data();
+        for (int r = 0; r < m_comm.size(); ++r)
+        {
+            detail::for_each_row(m_to, m_recv_boxes[r], [&](std::size_t offset, std::size_t length) {
+                std::copy(unpacked, unpacked + length, dst + offset);
+                unpacked += length;
+            });
+        }
+    }
+
+    // a warm-up and three timed runs of each method on scratch arrays, the slowest rank decides.
+    redistribution_method choose()
+    {
+        std::vector<T> src(source_size()), dst(target_size());
+        m_send_buffer.resize(m_send_displs.back() + m_send_counts.back());
+        m_recv_buffer.resize(m_recv_displs.back() + m_recv_counts.back());
+        double times[2];
+        const redistribution_method methods[2] = {redistribution_method::alltoallw, redistribution_method::packed};
+        for (int m = 0; m < 2; ++m)
+        {
+            execute(src.data(), dst.data(), methods[m]);
+            m_comm.barrier();
+            double start = MPI_Wtime();
+            for (int i = 0; i < 3; ++i)
+            {
+                execute(src.data(), dst.data(), methods[m]);
+            }
+            double local = MPI_Wtime() - start;
+            m_comm.allreduce(local, times[m], op::max());
+        }
+        m_send_buffer = {};
+        m_recv_buffer = {};
+        return times[1] < times[0] ? redistribution_method::packed : redistribution_method::alltoallw;
+    }
+};
+
+} // end namespace mpi
+
+#endif // MPI_TRANSPOSE_HPP
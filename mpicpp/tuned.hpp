@@ -0,0 +1,478 @@
+#pragma once
+#ifndef MPI_TUNED_HPP
+#define MPI_TUNED_HPP
+
+#include "communicator.hpp"
+#include "environment.hpp"
+#include "partition.hpp"
+#include "types.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace mpi
+{
+
+// Tuned collectives: allreduce and alltoall algorithms written on point-to-point, picked per communicator size and
+// message size from a tuning table. tune_collectives() measures them and fills the table; if the environment variable
+// MPICPP_TUNING_FILE names a saved table, the environment constructor loads it. The messages use `tuned_tag` on the
+// given communicator.
+
+inline constexpr int tuned_tag = 32764;
+
+enum class allreduce_algorithm
+{
+    library, // MPI_Allreduce
+    recursive_doubling,
+    ring,
+    rabenseifner
+};
+
+enum class alltoall_algorithm
+{
+    library, // MPI_Alltoall
+    pairwise
+};
+
+inline const char *to_string(allreduce_algorithm algorithm)
+{
+    switch (algorithm)
+    {
+        case allreduce_algorithm::library: return "library";
+        case allreduce_algorithm::recursive_doubling: return "recursive_doubling";
+        case allreduce_algorithm::ring: return "ring";
+        case allreduce_algorithm::rabenseifner: return "rabenseifner";
+    }
+    return "unknown";
+}
+
+inline const char *to_string(alltoall_algorithm algorithm)
+{
+    switch (algorithm)
+    {
+        case alltoall_algorithm::library: return "library";
+        case alltoall_algorithm::pairwise: return "pairwise";
+    }
+    return "unknown";
+}
+
+namespace detail
+{
+
+// The ranks beyond the largest power of two p' fold into a partner first: of the first 2 (p - p') ranks, the even
+// ones hand their data to the odd ones and sit out. Returns the rank in the power-of-two group, -1 for those sitting
+// out.
+template <typename T>
+int fold_to_power_of_two(const communicator &comm, T *data, T *scratch, std::size_t count, MPI_Op op, int &pof2)
+{
+    const int p = comm.size(), r = comm.rank();
+    pof2 = 1;
+    while (pof2 * 2 <= p)
+    {
+        pof2 *= 2;
+    }
+    const int rem = p - pof2;
+    if (r < 2 * rem)
+    {
+        if (r % 2 == 0)
+        {
+            comm.send(data, count, r + 1, tuned_tag);
+            return -1;
+        }
+        comm.recv(scratch, count, r - 1, tuned_tag);
+        CHECK_MPI(MPI_Reduce_local(scratch, data, count, mpi_type<T>(), op));
+        return r / 2;
+    }
+    return r - rem;
+}
+
+inline int unfolded_rank(int group_rank, int rem) { return group_rank < rem ? group_rank * 2 + 1 : group_rank + rem; }
+
+// the ranks which sat out get the result back
+template <typename T>
+void unfold(const communicator &comm, T *data, std::size_t count, int pof2)
+{
+    const int r = comm.rank(), rem = comm.size() - pof2;
+    if (r < 2 * rem)
+    {
+        if (r % 2 == 0)
+            comm.recv(data, count, r + 1, tuned_tag);
+        else
+            comm.send(data, count, r - 1, tuned_tag);
+    }
+}
+
+} // end namespace detail
+
+// ----- algorithms -----
+
+// The allreduce algorithms combine in an order which depends on the rank count, `op` must be commutative.
+
+// log2(p) exchanges of the whole vector: the fewest messages, for small counts.
+template <typename T>
+void allreduce_recursive_doubling(const communicator &comm, const T *send_data, T *recv_data, std::size_t count,
+                                  MPI_Op op)
+{
+    std::copy(send_data, send_data + count, recv_data);
+    std::vector<T> scratch(count);
+    int pof2;
+    const int group_rank = detail::fold_to_power_of_two(comm, recv_data, scratch.data(), count, op, pof2);
+    if (group_rank >= 0)
+    {
+        const int rem = comm.size() - pof2;
+        for (int mask = 1; mask < pof2; mask <<= 1)
+        {
+            int partner = detail::unfolded_rank(group_rank ^ mask, rem);
+            comm.sendrecv(recv_data, count, partner, tuned_tag, scratch.data(), count, partner, tuned_tag);
+            CHECK_MPI(MPI_Reduce_local(scratch.data(), recv_data, count, mpi_type<T>(), op));
+        }
+    }
+    detail::unfold(comm, recv_data, count, pof2);
+}
+
+// Reduce-scatter then allgather around a ring, 2 (p - 1) steps of count / p elements: bandwidth optimal, for large
+// counts.
+template <typename T>
+void allreduce_ring(const communicator &comm, const T *send_data, T *recv_data, std::size_t count, MPI_Op op)
+{
+    std::copy(send_data, send_data + count, recv_data);
+    const int p = comm.size(), r = comm.rank();
+    if (p == 1)
+        return;
+    const block_partition blocks(count, p);
+    const int right = (r + 1) % p, left = (r + p - 1) % p;
+    auto block = [&](int b) { return ((b % p) + p) % p; };
+    std::vector<T> scratch(blocks.size(0));
+    for (int step = 0; step < p - 1; ++step)
+    {
+        int out = block(r - step), in = block(r - step - 1);
+        comm.sendrecv(recv_data + blocks.begin(out), blocks.size(out), right, tuned_tag, scratch.data(),
+                      blocks.size(in), left, tuned_tag);
+        CHECK_MPI(MPI_Reduce_local(scratch.data(), recv_data + blocks.begin(in), blocks.size(in), mpi_type<T>(), op));
+    }
+    for (int step = 0; step < p - 1; ++step)
+    {
+        int out = block(r + 1 - step), in = block(r - step);
+        comm.sendrecv(recv_data + blocks.begin(out), blocks.size(out), right, tuned_tag, recv_data + blocks.begin(in),
+                      blocks.size(in), left, tuned_tag);
+    }
+}
+
+// Reduce-scatter by recursive halving, then allgather by recursive doubling: log2(p) steps and about twice the
+// data volume of the vector, for medium to large counts.
+template <typename T>
+void allreduce_rabenseifner(const communicator &comm, const T *send_data, T *recv_data, std::size_t count, MPI_Op op)
+{
+    std::copy(send_data, send_data + count, recv_data);
+    std::vector<T> scratch(count);
+    int pof2;
+    const int group_rank = detail::fold_to_power_of_two(comm, recv_data, scratch.data(), count, op, pof2);
+    if (group_rank >= 0)
+    {
+        const int rem = comm.size() - pof2;
+        const block_partition blocks(count, pof2);
+        auto offset = [&](int b) { return blocks.begin(b); };
+        // [lo, hi) are the blocks this rank is still responsible for
+        int lo = 0, hi = pof2;
+        for (int mask = pof2 / 2; mask >= 1; mask >>= 1)
+        {
+            int partner = detail::unfolded_rank(group_rank ^ mask, rem);
+            int mid = (lo + hi) / 2;
+            int keep_lo = group_rank & mask ? mid : lo, keep_hi = group_rank & mask ? hi : mid;
+            int send_lo = group_rank & mask ? lo : mid, send_hi = group_rank & mask ? mid : hi;
+            std::size_t keep = offset(keep_hi) - offset(keep_lo);
+            comm.sendrecv(recv_data + offset(send_lo), offset(send_hi) - offset(send_lo), partner, tuned_tag,
+                          scratch.data(), keep, partner, tuned_tag);
+            CHECK_MPI(MPI_Reduce_local(scratch.data(), recv_data + offset(keep_lo), keep, mpi_type<T>(), op));
+            lo = keep_lo;
+            hi = keep_hi;
+        }
+        for (int mask = 1; mask < pof2; mask <<= 1)
+        {
+            int partner = detail::unfolded_rank(group_rank ^ mask, rem);
+            int other_lo = group_rank & mask ? lo - mask : hi, other_hi = other_lo + mask;
+            comm.sendrecv(recv_data + offset(lo), offset(hi) - offset(lo), partner, tuned_tag,
+                          recv_data + offset(other_lo), offset(other_hi) - offset(other_lo), partner, tuned_tag);
+            lo = std::min(lo, other_lo);
+            hi = std::max(hi, other_hi);
+        }
+    }
+    detail::unfold(comm, recv_data, count, pof2);
+}
+
+// p - 1 exchanges with a different partner each, `count` elements per rank.
+template <typename T>
+void alltoall_pairwise(const communicator &comm, const T *send_data, T *recv_data, std::size_t count)
+{
+    const int p = comm.size(), r = comm.rank();
+    std::copy(send_data + r * count, send_data + (r + 1) * count, recv_data + r * count);
+    for (int step = 1; step < p; ++step)
+    {
+        int dest = (r + step) % p, src = (r + p - step) % p;
+        comm.sendrecv(send_data + dest * count, count, dest, tuned_tag, recv_data + src * count, count, src,
+                      tuned_tag);
+    }
+}
+
+template <typename T>
+void allreduce_with(allreduce_algorithm algorithm, const communicator &comm, const T *send_data, T *recv_data,
+                    std::size_t count, MPI_Op op)
+{
+    switch (algorithm)
+    {
+        case allreduce_algorithm::library: comm.allreduce(send_data, recv_data, count, op); break;
+        case allreduce_algorithm::recursive_doubling:
+            allreduce_recursive_doubling(comm, send_data, recv_data, count, op);
+            break;
+        case allreduce_algorithm::ring: allreduce_ring(comm, send_data, recv_data, count, op); break;
+        case allreduce_algorithm::rabenseifner: allreduce_rabenseifner(comm, send_data, recv_data, count, op); break;
+    }
+}
+
+template <typename T>
+void alltoall_with(alltoall_algorithm algorithm, const communicator &comm, const T *send_data, T *recv_data,
+                   std::size_t count)
+{
+    if (algorithm == alltoall_algorithm::pairwise)
+        alltoall_pairwise(comm, send_data, recv_data, count);
+    else
+        comm.alltoall(send_data, static_cast<int>(count), recv_data, static_cast<int>(count));
+}
+
+// ----- tuning table -----
+
+// The winning algorithm per communicator size and message size. A message of n bytes uses the entry with the
+// smallest size >= n, or the largest entry; sizes without entries use the library. Saved as text lines
+// `<collective> <communicator size> <bytes> <algorithm>`.
+class tuning_table
+{
+  private:
+    std::map<int, std::map<std::size_t, allreduce_algorithm>> m_allreduce;
+    std::map<int, std::map<std::size_t, alltoall_algorithm>> m_alltoall;
+
+    template <typename A>
+    static A lookup(const std::map<int, std::map<std::size_t, A>> &table, int comm_size, std::size_t bytes)
+    {
+        auto sizes = table.find(comm_size);
+        if (sizes == table.end() || sizes->second.empty())
+            return A::library;
+        auto it = sizes->second.lower_bound(bytes);
+        return it != sizes->second.end() ? it->second : sizes->second.rbegin()->second;
+    }
+
+  public:
+    // loaded by the environment, filled by tune_collectives(); not synchronized, set it up before starting threads.
+    static tuning_table &global()
+    {
+        static tuning_table table;
+        return table;
+    }
+
+    allreduce_algorithm allreduce(int comm_size, std::size_t bytes) const
+    {
+        return lookup(m_allreduce, comm_size, bytes);
+    }
+    // `bytes` per peer
+    alltoall_algorithm alltoall(int comm_size, std::size_t bytes) const { return lookup(m_alltoall, comm_size, bytes); }
+
+    void set(int comm_size, std::size_t bytes, allreduce_algorithm algorithm)
+    {
+        m_allreduce[comm_size][bytes] = algorithm;
+    }
+    void set(int comm_size, std::size_t bytes, alltoall_algorithm algorithm)
+    {
+        m_alltoall[comm_size][bytes] = algorithm;
+    }
+    void clear()
+    {
+        m_allreduce.clear();
+        m_alltoall.clear();
+    }
+
+    std::string str() const
+    {
+        std::ostringstream out;
+        out << "# collective, communicator size, up to bytes, algorithm\n";
+        for (const auto &[comm_size, sizes] : m_allreduce)
+        {
+            for (const auto &[bytes, algorithm] : sizes)
+            {
+                out << "allreduce " << comm_size << ' ' << bytes << ' ' << to_string(algorithm) << '\n';
+            }
+        }
+        for (const auto &[comm_size, sizes] : m_alltoall)
+        {
+            for (const auto &[bytes, algorithm] : sizes)
+            {
+                out << "alltoall " << comm_size << ' ' << bytes << ' ' << to_string(algorithm) << '\n';
+            }
+        }
+        return out.str();
+    }
+
+    // merges the entries of `text`, unknown lines are skipped
+    void parse(const std::string &text)
+    {
+        std::istringstream in(text);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::istringstream fields(line);
+            std::string collective, name;
+            int comm_size;
+            std::size_t bytes;
+            if (!(fields >> collective >> comm_size >> bytes >> name))
+                continue;
+            if (collective == "allreduce")
+            {
+                for (auto a : {allreduce_algorithm::library, allreduce_algorithm::recursive_doubling,
+                               allreduce_algorithm::ring, allreduce_algorithm::rabenseifner})
+                {
+                    if (name == to_string(a))
+                        set(comm_size, bytes, a);
+                }
+            }
+            else if (collective == "alltoall")
+            {
+                for (auto a : {alltoall_algorithm::library, alltoall_algorithm::pairwise})
+                {
+                    if (name == to_string(a))
+                        set(comm_size, bytes, a);
+                }
+            }
+        }
+    }
+
+    bool save(const std::string &path) const
+    {
+        std::ofstream out(path);
+        out << str();
+        return static_cast<bool>(out);
+    }
+
+    // not collective, see load(comm, path)
+    bool load(const std::string &path)
+    {
+        std::ifstream in(path);
+        if (!in)
+            return false;
+        std::ostringstream text;
+        text << in.rdbuf();
+        parse(text.str());
+        return true;
+    }
+
+    // collective: the root reads the file and broadcasts it, so every rank dispatches the same way.
+    bool load(const communicator &comm, const std::string &path, int root = 0)
+    {
+        std::string text;
+        int found = 0;
+        if (comm.rank() == root)
+        {
+            std::ifstream in(path);
+            if (in)
+            {
+                std::ostringstream content;
+                content << in.rdbuf();
+                text = content.str();
+                found = 1;
+            }
+        }
+        comm.broadcast(found, root);
+        comm.broadcast(text, root);
+        parse(text);
+        return found;
+    }
+};
+
+namespace detail
+{
+
+inline const bool tuning_table_loaded = at_init([]() {
+    if (const char *path = std::getenv("MPICPP_TUNING_FILE"))
+        tuning_table::global().load(world, path);
+});
+
+} // end namespace detail
+
+// ----- dispatch -----
+
+// the algorithm of the global tuning table; non-commutative ops always use the library.
+template <typename T>
+void tuned_allreduce(const communicator &comm, const T *send_data, T *recv_data, std::size_t count, MPI_Op op)
+{
+    int commutative;
+    CHECK_MPI(MPI_Op_commutative(op, &commutative));
+    auto algorithm = commutative ? tuning_table::global().allreduce(comm.size(), count * sizeof(T))
+                                 : allreduce_algorithm::library;
+    allreduce_with(algorithm, comm, send_data, recv_data, count, op);
+}
+
+// `count` elements per rank
+template <typename T>
+void tuned_alltoall(const communicator &comm, const T *send_data, T *recv_data, std::size_t count)
+{
+    alltoall_with(tuning_table::global().alltoall(comm.size(), count * sizeof(T)), comm, send_data, recv_data,
+                  count);
+}
+
+// ----- tuning -----
+
+struct tuning_options
+{
+    std::size_t min_bytes = 8;
+    std::size_t max_bytes = std::size_t(4) << 20;
+    int repetitions = 10;
+};
+
+// Collective: times every algorithm on doubles for message sizes from min_bytes to max_bytes (factors of 4) and
+// records the fastest, as seen by the slowest rank, for comm.size() in the global table. Save the table from one
+// rank with tuning_table::global().save(path).
+inline void tune_collectives(const communicator &comm, tuning_options options = {})
+{
+    auto timed = [&](auto run) {
+        run(); // warm-up
+        comm.barrier();
+        double start = MPI_Wtime();
+        for (int i = 0; i < options.repetitions; ++i)
+        {
+            run();
+        }
+        double local = MPI_Wtime() - start, slowest;
+        comm.allreduce(local, slowest, op::max());
+        return slowest;
+    };
+    auto &table = tuning_table::global();
+    const int p = comm.size();
+    for (std::size_t bytes = options.min_bytes; bytes <= options.max_bytes; bytes *= 4)
+    {
+        const std::size_t count = std::max<std::size_t>(1, bytes / sizeof(double));
+        std::vector<double> send(count * p, 1.0), recv(count * p);
+
+        allreduce_algorithm best_allreduce = allreduce_algorithm::library;
+        double best = timed([&]() { comm.allreduce(send.data(), recv.data(), count, op::sum()); });
+        for (auto a : {allreduce_algorithm::recursive_doubling, allreduce_algorithm::ring,
+                       allreduce_algorithm::rabenseifner})
+        {
+            double t = timed([&]() { allreduce_with(a, comm, send.data(), recv.data(), count, op::sum()); });
+            if (t < best)
+            {
+                best = t;
+                best_allreduce = a;
+            }
+        }
+        table.set(p, bytes, best_allreduce);
+
+        double library = timed([&]() { comm.alltoall(send.data(), int(count), recv.data(), int(count)); });
+        double pairwise = timed([&]() { alltoall_pairwise(comm, send.data(), recv.data(), count); });
+        table.set(p, bytes, pairwise < library ? alltoall_algorithm::pairwise : alltoall_algorithm::library);
+    }
+}
+
+} // end namespace mpi
+
+#endif // MPI_TUNED_HPP
@@ -2,17 +2,41 @@
 #ifndef MPI_TYPES_HPP
 #define MPI_TYPES_HPP
 
+#include "environment.hpp"
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <complex>
+#include <concepts>
+#include <functional>
+#include <limits>
 #include <mpi.h>
+#include <mutex>
+#include <ranges>
 #include <type_traits>
+#include <utility>
 
 namespace mpi
 {
 
+// Commit a derived datatype built once per program, MPI_Finalize frees it.
+inline MPI_Datatype commit_type(MPI_Datatype type)
+{
+    CHECK_MPI(MPI_Type_commit(&type));
+    at_finalize([type]() mutable { MPI_Type_free(&type); });
+    return type;
+}
+
+// user types can provide `static MPI_Datatype mpi_type()`, usually built with commit_type.
+template <typename T>
+const MPI_Datatype mpi_type()
+{
+    if constexpr (requires { T::mpi_type(); })
+        return T::mpi_type();
+    else
+        return MPI_DATATYPE_NULL;
+}
 // clang-format off
-template <typename T> const MPI_Datatype mpi_type() { return MPI_DATATYPE_NULL; }
 template <> const MPI_Datatype mpi_type<char>() { return MPI_CHAR; }
 template <> const MPI_Datatype mpi_type<unsigned char>() { return MPI_UNSIGNED_CHAR; }
 template <> const MPI_Datatype mpi_type<signed char>() { return MPI_SIGNED_CHAR; }
@@ -42,7 +66,312 @@ inline void check_type()
     assert(mpi_type<T>() != MPI_DATATYPE_NULL && "Unsupported type");
 }
 
-// TODO: not good, maybe a better implementation.
+// MPI-4 has `_c` variants of the communication and I/O functions taking an MPI_Count. MPICPP_COUNTED(MPI_Send) names
+// the variant to call with the pair of a detail::large_count.
+#if MPI_VERSION >= 4 && !defined(MPICPP_NO_LARGE_COUNT)
+#define MPICPP_LARGE_COUNT
+#define MPICPP_COUNTED(function) function##_c
+#else
+#define MPICPP_COUNTED(function) function
+#endif
+
+namespace detail
+{
+
+// the count argument of MPICPP_COUNTED functions
+#ifdef MPICPP_LARGE_COUNT
+using count_type = MPI_Count;
+#else
+using count_type = int;
+#endif
+
+// `count` elements of `type` as the (count, datatype) pair of an MPICPP_COUNTED function. With MPI-4 this is the
+// pair itself. Before, when the count does not fit in an int, it is one element of a derived type made of blocks of
+// INT_MAX elements followed by the remainder, freed with this object. Predefined reduction ops do not accept derived
+// types, reductions are split with for_each_chunk instead.
+class large_count
+{
+  private:
+    count_type m_count;
+    MPI_Datatype m_type;
+    bool m_owned;
+
+  public:
+    // the most elements one call takes
+    static constexpr std::size_t max_count = std::numeric_limits<count_type>::max();
+
+    large_count(std::size_t count, MPI_Datatype type)
+        : m_count(static_cast<count_type>(count)), m_type(type), m_owned(false)
+    {
+        if (count <= max_count)
+            return;
+        constexpr int block = std::numeric_limits<int>::max();
+        std::size_t blocks = count / block, rest = count % block;
+        MPI_Datatype body;
+        CHECK_MPI(MPI_Type_vector(static_cast<int>(blocks), block, block, type, &body));
+        if (rest == 0)
+        {
+            m_type = body;
+        }
+        else
+        {
+            MPI_Aint lb, extent;
+            CHECK_MPI(MPI_Type_get_extent(type, &lb, &extent));
+            MPI_Datatype tail;
+            CHECK_MPI(MPI_Type_contiguous(static_cast<int>(rest), type, &tail));
+            int lengths[2] = {1, 1};
+            MPI_Aint displs[2] = {0, static_cast<MPI_Aint>(blocks * block) * extent};
+            MPI_Datatype types[2] = {body, tail};
+            CHECK_MPI(MPI_Type_create_struct(2, lengths, displs, types, &m_type));
+            CHECK_MPI(MPI_Type_free(&body));
+            CHECK_MPI(MPI_Type_free(&tail));
+        }
+        CHECK_MPI(MPI_Type_commit(&m_type));
+        m_count = 1;
+        m_owned = true;
+    }
+    large_count(const large_count &) = delete;
+    large_count &operator=(const large_count &) = delete;
+    // a pending non-blocking operation keeps its own reference, so freeing here is fine.
+    ~large_count()
+    {
+        if (m_owned)
+            MPI_Type_free(&m_type);
+    }
+    count_type count() const { return m_count; }
+    MPI_Datatype type() const { return m_type; }
+};
+
+// chunk [offset, offset + n) of a buffer which may be null (e.g. the receive buffer of reduce on non-root ranks) or
+// MPI_IN_PLACE
+template <typename T>
+T *chunk(T *ptr, std::size_t offset)
+{
+    if (ptr == nullptr || static_cast<const void *>(ptr) == MPI_IN_PLACE)
+        return ptr;
+    return ptr + offset;
+}
+
+// calls f(offset, n) for consecutive chunks [offset, offset + n) of at most large_count::max_count elements which
+// cover [0, count), at least once
+template <typename F>
+void for_each_chunk(std::size_t count, F f)
+{
+    std::size_t offset = 0;
+    do
+    {
+        std::size_t n = std::min(count - offset, large_count::max_count);
+        f(offset, static_cast<count_type>(n));
+        offset += n;
+    } while (offset < count);
+}
+
+} // end namespace detail
+
+// functors for MPI_MIN and MPI_MAX, the standard library has none.
+template <typename T = void>
+struct minimum
+{
+    constexpr T operator()(const T &a, const T &b) const { return b < a ? b : a; }
+};
+template <>
+struct minimum<void>
+{
+    template <typename T>
+    constexpr T operator()(const T &a, const T &b) const
+    {
+        return b < a ? b : a;
+    }
+};
+template <typename T = void>
+struct maximum
+{
+    constexpr T operator()(const T &a, const T &b) const { return a < b ? b : a; }
+};
+template <>
+struct maximum<void>
+{
+    template <typename T>
+    constexpr T operator()(const T &a, const T &b) const
+    {
+        return a < b ? b : a;
+    }
+};
+
+namespace detail
+{
+
+template <typename T>
+struct is_complex : std::false_type
+{
+};
+template <typename T>
+struct is_complex<std::complex<T>> : std::true_type
+{
+};
+
+// `U` is the argument of the functor template, void for the transparent specialization.
+template <typename U, typename T>
+constexpr bool functor_of = std::is_same_v<U, T> || std::is_void_v<U>;
+template <typename T>
+constexpr bool sum_type = std::is_arithmetic_v<T> && !std::is_same_v<T, bool> || is_complex<T>::value;
+template <typename T>
+constexpr bool bit_type = std::is_integral_v<T> && !std::is_same_v<T, bool>;
+template <typename T>
+constexpr bool logical_type = std::is_integral_v<T>;
+template <typename T>
+constexpr bool order_type = std::is_arithmetic_v<T> && !std::is_same_v<T, bool>;
+
+// compile-time map from a functor to the predefined MPI_Op which computes the same thing on T.
+template <typename Func, typename T>
+struct builtin_op : std::false_type
+{
+};
+// clang-format off
+template <typename U, typename T> requires functor_of<U, T> && sum_type<T>
+struct builtin_op<std::plus<U>, T> : std::true_type { static MPI_Op get() { return MPI_SUM; } };
+template <typename U, typename T> requires functor_of<U, T> && sum_type<T>
+struct builtin_op<std::multiplies<U>, T> : std::true_type { static MPI_Op get() { return MPI_PROD; } };
+template <typename U, typename T> requires functor_of<U, T> && bit_type<T>
+struct builtin_op<std::bit_and<U>, T> : std::true_type { static MPI_Op get() { return MPI_BAND; } };
+template <typename U, typename T> requires functor_of<U, T> && bit_type<T>
+struct builtin_op<std::bit_or<U>, T> : std::true_type { static MPI_Op get() { return MPI_BOR; } };
+template <typename U, typename T> requires functor_of<U, T> && bit_type<T>
+struct builtin_op<std::bit_xor<U>, T> : std::true_type { static MPI_Op get() { return MPI_BXOR; } };
+template <typename U, typename T> requires functor_of<U, T> && logical_type<T>
+struct builtin_op<std::logical_and<U>, T> : std::true_type { static MPI_Op get() { return MPI_LAND; } };
+template <typename U, typename T> requires functor_of<U, T> && logical_type<T>
+struct builtin_op<std::logical_or<U>, T> : std::true_type { static MPI_Op get() { return MPI_LOR; } };
+template <typename U, typename T> requires functor_of<U, T> && order_type<T>
+struct builtin_op<minimum<U>, T> : std::true_type { static MPI_Op get() { return MPI_MIN; } };
+template <typename U, typename T> requires functor_of<U, T> && order_type<T>
+struct builtin_op<maximum<U>, T> : std::true_type { static MPI_Op get() { return MPI_MAX; } };
+// clang-format on
+
+// A functor without state: a cached op can construct it inside the callback.
+template <typename Func>
+constexpr bool stateless_functor = std::is_empty_v<Func> && std::is_default_constructible_v<Func>;
+
+// Applies `func` to the buffers of an MPI user function. `len` counts elements of `datatype`, which is a contiguous
+// multiple of T when the message was split into large blocks. Functors with a block overload
+// `f(const T *in, T *inout, std::size_t n)` get the whole buffer.
+template <typename T, typename Func>
+void apply_user_function(const Func &func, void *invec, void *inoutvec, int *len, MPI_Datatype *datatype)
+{
+    std::size_t n = *len;
+    if (*datatype != mpi_type<T>())
+    {
+        MPI_Aint lb, extent;
+        MPI_Type_get_extent(*datatype, &lb, &extent);
+        n *= extent / sizeof(T);
+    }
+    const T *in = static_cast<const T *>(invec);
+    T *out = static_cast<T *>(inoutvec);
+    if constexpr (std::is_invocable_v<const Func &, const T *, T *, std::size_t>)
+    {
+        func(in, out, n);
+    }
+    else
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            out[i] = func(in[i], out[i]);
+        }
+    }
+}
+
+// One MPI_Op per (T, Func, commute) for stateless functors, created on first use and freed by MPI_Finalize.
+template <typename T, typename Func>
+class user_op
+{
+    static_assert(stateless_functor<Func>, "user_op needs a stateless functor");
+
+  private:
+    static void call(void *invec, void *inoutvec, int *len, MPI_Datatype *datatype)
+    {
+        apply_user_function<T>(Func{}, invec, inoutvec, len, datatype);
+    }
+
+    static MPI_Op create(bool commute)
+    {
+        MPI_Op op;
+        CHECK_MPI(MPI_Op_create(&call, commute, &op));
+        at_finalize([op]() mutable { MPI_Op_free(&op); });
+        return op;
+    }
+
+  public:
+    static MPI_Op get(bool commute)
+    {
+        if (commute)
+        {
+            static MPI_Op commute_op = create(true);
+            return commute_op;
+        }
+        static MPI_Op op = create(false);
+        return op;
+    }
+};
+
+// MPI user functions get no context pointer, so a functor with state is bound to one of `slots` callbacks per
+// (T, Func), each reading its own slot. An op holds its slot until it is freed, so concurrent reductions (other
+// threads, or a call still running) each see their own functor.
+template <typename T, typename Func>
+class bound_op
+{
+  private:
+    static constexpr std::size_t slots = 64;
+    static inline std::mutex s_mutex;
+    static inline std::array<const Func *, slots> s_funcs{};
+
+    template <std::size_t I>
+    static void call(void *invec, void *inoutvec, int *len, MPI_Datatype *datatype)
+    {
+        apply_user_function<T>(*s_funcs[I], invec, inoutvec, len, datatype);
+    }
+    template <std::size_t... I>
+    static constexpr std::array<MPI_User_function *, slots> make_callbacks(std::index_sequence<I...>)
+    {
+        return {&call<I>...};
+    }
+    static constexpr std::array<MPI_User_function *, slots> s_callbacks =
+        make_callbacks(std::make_index_sequence<slots>{});
+
+    Func m_func;
+    std::size_t m_slot = slots;
+    MPI_Op m_op = MPI_OP_NULL;
+
+  public:
+    bound_op(Func func, bool commute) : m_func(std::move(func))
+    {
+        {
+            std::lock_guard lock(s_mutex);
+            for (std::size_t i = 0; i < slots; ++i)
+            {
+                if (s_funcs[i] == nullptr)
+                {
+                    s_funcs[i] = &m_func;
+                    m_slot = i;
+                    break;
+                }
+            }
+        }
+        assert(m_slot < slots && "bound_op: too many reductions with this functor type in flight");
+        CHECK_MPI(MPI_Op_create(s_callbacks[m_slot], commute, &m_op));
+    }
+    bound_op(const bound_op &) = delete;
+    bound_op &operator=(const bound_op &) = delete;
+    ~bound_op()
+    {
+        MPI_Op_free(&m_op);
+        std::lock_guard lock(s_mutex);
+        s_funcs[m_slot] = nullptr;
+    }
+    MPI_Op get() const { return m_op; }
+};
+
+} // end namespace detail
+
 struct op
 {
     static MPI_Op null() { return MPI_OP_NULL; }
@@ -60,26 +389,81 @@ struct op
     static MPI_Op maxloc() { return MPI_MAXLOC; }
     static MPI_Op replace() { return MPI_REPLACE; }
 
+    // Standard functors (std::plus, std::multiplies, std::bit_and/or/xor, std::logical_and/or, mpi::minimum/maximum)
+    // map to the predefined op at compile time. Any other stateless functor becomes a user op created once per
+    // (T, Func, commute), which MPI_Finalize frees. Functors with state (e.g. lambdas with captures) need an op of
+    // their own, see functor_op.
+    template <typename T, typename Func>
+    static MPI_Op custom(Func, bool commute)
+    {
+        static_assert(std::is_invocable_r<T, Func, T, T>::value, "Func must be T(T,T)");
+        if constexpr (detail::builtin_op<Func, T>::value)
+        {
+            return detail::builtin_op<Func, T>::get();
+        }
+        else
+        {
+            static_assert(detail::stateless_functor<Func>, "op::custom needs a stateless functor, use functor_op");
+            return detail::user_op<T, Func>::get(commute);
+        }
+    }
+
     template <typename T, typename Func>
     static MPI_Op custom(bool commute)
     {
-        static_assert(std::is_invocable<Func, T, T>::value, "Func must be T(T,T)");
-        MPI_Op op;
-        MPI_Op_create(&func<T, Func>, commute, &op);
-        return op;
+        return custom<T>(Func{}, commute);
     }
+};
 
+// functor usable in place of an MPI_Op for reductions on T
+template <typename Func, typename T>
+concept reduction_functor = std::is_invocable_r_v<T, Func, T, T> && !std::is_convertible_v<Func, MPI_Op>;
+
+// The MPI_Op of any functor for the duration of a reduction: the predefined or cached op when the functor maps to
+// one (see op::custom), otherwise an op bound to this object's copy of the functor and freed with it. `commute`
+// declares the functor commutative, which lets MPI combine in any order.
+template <typename T, typename Func>
+class functor_op
+{
   private:
-    template <typename T, typename Func>
-    static void func(void *invec, void *inoutvec, int *len, MPI_Datatype *datatype)
+    static constexpr bool cached = detail::builtin_op<Func, T>::value || detail::stateless_functor<Func>;
+    std::conditional_t<cached, MPI_Op, detail::bound_op<T, Func>> m_op;
+
+  public:
+    functor_op(Func func, bool commute)
+        : m_op([&]() -> decltype(m_op) {
+              if constexpr (cached)
+                  return op::custom<T>(std::move(func), commute);
+              else
+                  return {std::move(func), commute};
+          }())
     {
-        T *in = static_cast<T *>(invec);
-        T *out = static_cast<T *>(inoutvec);
-        Func func;
-        std::transform(in, in + *len, out, out, func);
+    }
+    MPI_Op get() const
+    {
+        if constexpr (cached)
+            return m_op;
+        else
+            return m_op.get();
     }
 };
 
+// std::array, std::span, sub-ranges of a vector...: passed to communicator as their elements, in place.
+template <typename R>
+concept contiguous_buffer = std::ranges::contiguous_range<R> && std::ranges::sized_range<R>;
+
+// A non-contiguous selection of memory described by a derived datatype (see view.hpp), passed as one element of
+// `type()` at `data()`.
+template <typename V>
+concept datatype_view = requires(const V &v) {
+    v.data();
+    { v.type() } -> std::same_as<MPI_Datatype>;
+};
+
+// the overloads taking a single value by value or reference leave ranges and views to their own overloads.
+template <typename T>
+concept single_element = !contiguous_buffer<T> && !datatype_view<T>;
+
 } // end namespace mpi
 
 #endif // MPI_TYPES_HPP
\ No newline at end of file
@@ -0,0 +1,142 @@
+#pragma once
+#ifndef MPI_VIEW_HPP
+#define MPI_VIEW_HPP
+
+#include "types.hpp"
+#include <array>
+#include <cassert>
+#include <climits>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace mpi
+{
+
+// Views of non-contiguous memory which communicator sends and receives in place through a derived datatype (see
+// datatype_view in types.hpp). A view owns its committed datatype: it is move-only and must be destroyed before
+// MPI_Finalize. Create it once and reuse it, e.g. for every halo exchange of a time loop.
+
+namespace detail
+{
+
+class datatype_handle
+{
+  private:
+    MPI_Datatype m_type = MPI_DATATYPE_NULL;
+
+  public:
+    datatype_handle() = default;
+    explicit datatype_handle(MPI_Datatype type) : m_type(type) { CHECK_MPI(MPI_Type_commit(&m_type)); }
+    datatype_handle(const datatype_handle &) = delete;
+    datatype_handle &operator=(const datatype_handle &) = delete;
+    datatype_handle(datatype_handle &&other) noexcept : m_type(std::exchange(other.m_type, MPI_DATATYPE_NULL)) {}
+    datatype_handle &operator=(datatype_handle &&other) noexcept
+    {
+        std::swap(m_type, other.m_type);
+        return *this;
+    }
+    ~datatype_handle()
+    {
+        if (m_type != MPI_DATATYPE_NULL)
+            MPI_Type_free(&m_type);
+    }
+    MPI_Datatype get() const { return m_type; }
+};
+
+} // end namespace detail
+
+// `count` blocks of `block_length` elements, the blocks `stride` elements apart (MPI_Type_vector). Column j of a
+// row-major rows x cols matrix is strided_view(a + j, rows, cols). Use a const T to send from const memory.
+template <typename T>
+class strided_view
+{
+  private:
+    using value_type = std::remove_const_t<T>;
+
+    T *m_data;
+    std::size_t m_count;
+    std::size_t m_stride;
+    std::size_t m_block_length;
+    detail::datatype_handle m_type;
+
+  public:
+    strided_view(T *data, std::size_t count, std::size_t stride, std::size_t block_length = 1)
+        : m_data(data), m_count(count), m_stride(stride), m_block_length(block_length)
+    {
+        check_type<value_type>();
+        assert(count <= INT_MAX && stride <= INT_MAX && block_length <= stride);
+        MPI_Datatype type;
+        CHECK_MPI(MPI_Type_vector(static_cast<int>(count), static_cast<int>(block_length), static_cast<int>(stride),
+                                  mpi_type<value_type>(), &type));
+        m_type = detail::datatype_handle(type);
+    }
+
+    T *data() const { return m_data; }
+    MPI_Datatype type() const { return m_type.get(); }
+    // number of selected elements
+    std::size_t size() const { return m_count * m_block_length; }
+    T &operator[](std::size_t i) const { return m_data[i / m_block_length * m_stride + i % m_block_length]; }
+};
+
+// The block of `subsizes` elements at `starts` of a row-major N-dimensional array of `sizes` elements
+// (MPI_Type_create_subarray). `data` is the start of the whole array, e.g. the interior of a grid with ghost layers
+// is subarray_view(grid, {nx + 2, ny + 2}, {nx, ny}, {1, 1}).
+template <typename T, std::size_t N>
+class subarray_view
+{
+  private:
+    using value_type = std::remove_const_t<T>;
+
+    T *m_data;
+    std::array<int, N> m_sizes;
+    std::array<int, N> m_subsizes;
+    std::array<int, N> m_starts;
+    detail::datatype_handle m_type;
+
+  public:
+    subarray_view(T *data, const std::array<int, N> &sizes, const std::array<int, N> &subsizes,
+                  const std::array<int, N> &starts)
+        : m_data(data), m_sizes(sizes), m_subsizes(subsizes), m_starts(starts)
+    {
+        check_type<value_type>();
+        MPI_Datatype type;
+        CHECK_MPI(MPI_Type_create_subarray(static_cast<int>(N), m_sizes.data(), m_subsizes.data(), m_starts.data(),
+                                           MPI_ORDER_C, mpi_type<value_type>(), &type));
+        m_type = detail::datatype_handle(type);
+    }
+    // deduces N from braced lists
+    subarray_view(T *data, const int (&sizes)[N], const int (&subsizes)[N], const int (&starts)[N])
+        : subarray_view(data, std::to_array(sizes), std::to_array(subsizes), std::to_array(starts))
+    {
+    }
+
+    T *data() const { return m_data; }
+    MPI_Datatype type() const { return m_type.get(); }
+    const std::array<int, N> &sizes() const { return m_sizes; }
+    const std::array<int, N> &subsizes() const { return m_subsizes; }
+    const std::array<int, N> &starts() const { return m_starts; }
+    std::size_t size() const
+    {
+        std::size_t n = 1;
+        for (int s : m_subsizes)
+        {
+            n *= s;
+        }
+        return n;
+    }
+    // element at `index` relative to the start of the block
+    T &operator[](const std::array<int, N> &index) const
+    {
+        std::size_t offset = 0;
+        for (std::size_t d = 0; d < N; ++d)
+        {
+            offset = offset * m_sizes[d] + m_starts[d] + index[d];
+        }
+        return m_data[offset];
+    }
+};
+
+} // end namespace mpi
+
+#endif // MPI_VIEW_HPP
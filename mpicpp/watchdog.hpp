@@ -0,0 +1,272 @@
+#pragma once
+#ifndef MPI_WATCHDOG_HPP
+#define MPI_WATCHDOG_HPP
+
+#include "communicator.hpp"
+#include "environment.hpp"
+#include "logger.hpp"
+#include "tracking.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mpi
+{
+
+struct watchdog_options
+{
+    // an operation outstanding for longer is reported
+    std::chrono::duration<double> threshold{10.0};
+    // pause between two checks
+    std::chrono::milliseconds interval{200};
+    // ask the other ranks to log what they wait on as well, needs MPI_THREAD_MULTIPLE
+    bool notify_peers = true;
+};
+
+namespace detail
+{
+
+inline std::string describe(const tracked_operation &op)
+{
+    std::ostringstream oss;
+    oss << to_string(op.kind);
+    if (op.kind != operation::barrier)
+    {
+        oss << (op.kind == operation::send || op.kind == operation::isend ? " to " : " from ");
+        if (op.peer == MPI_ANY_SOURCE)
+            oss << "any";
+        else
+            oss << op.peer;
+        oss << " tag ";
+        if (op.tag == MPI_ANY_TAG)
+            oss << "any";
+        else
+            oss << op.tag;
+        oss << ", " << op.bytes << " bytes";
+    }
+    oss << ", " << std::fixed << std::setprecision(3) << op.age() << " s" << (op.waiting ? " (waiting)" : "");
+    return oss.str();
+}
+
+// the lines reporting the outstanding operations of this rank, oldest first
+inline std::vector<std::string> outstanding_report(const std::string &reason)
+{
+    auto ops = outstanding_operations();
+    std::sort(ops.begin(), ops.end(), [](const auto &a, const auto &b) { return a.start < b.start; });
+    std::vector<std::string> lines{reason + ": " + std::to_string(ops.size()) + " outstanding operation(s)"};
+    for (const auto &op : ops)
+    {
+        lines.push_back("  " + describe(op));
+    }
+    return lines;
+}
+
+} // end namespace detail
+
+// Logs the outstanding operations of this rank, oldest first.
+inline void log_outstanding_operations(const std::string &reason)
+{
+    for (const auto &line : detail::outstanding_report(reason))
+    {
+        log_warn(line);
+    }
+}
+
+// A thread which reports operations outstanding for longer than options.threshold, before the job sits until its
+// wall-time runs out. The report lists every operation this rank waits on, and with MPI_THREAD_MULTIPLE the other
+// ranks are told to log theirs too, so the log shows who waits on whom. Needs MPICPP_WATCHDOG (see tracking.hpp),
+// without it nothing is tracked and the watchdog stays silent. Construction and destruction are collective over
+// `comm`, destroy it before MPI_Finalize. The reports go through the Logger with MPI_THREAD_MULTIPLE. Below it the
+// thread must not call MPI, which the Logger does for the rank and the time, so it writes the same lines to std::cout
+// itself, timed by the steady clock from the Logger's time at construction.
+class watchdog
+{
+  private:
+    communicator m_comm;
+    watchdog_options m_options;
+    // the Logger prefix without MPI, see report()
+    int m_rank;
+    std::size_t m_rank_length;
+    double m_log_time;
+    std::chrono::steady_clock::time_point m_log_clock;
+    bool m_notify;
+    std::atomic<std::size_t> m_reports{0};
+    bool m_stop = false;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    // the notices to the other ranks
+    int m_notice = 0;
+    MPI_Request m_notice_recv = MPI_REQUEST_NULL;
+    std::vector<MPI_Request> m_notice_sends;
+    std::thread m_thread;
+
+  public:
+    explicit watchdog(const communicator &comm = world, watchdog_options options = {})
+        : m_comm(comm.dup()), m_options(options), m_rank(world.rank()),
+          m_rank_length(std::to_string(world.size()).size()), m_log_time(MPI_Wtime() - Logger::instance().start_time()),
+          m_log_clock(std::chrono::steady_clock::now()),
+          m_notify(options.notify_peers && environment::query_thread_level() == thread_level::multiple)
+    {
+        if constexpr (!tracking_enabled)
+        {
+            if (m_comm.rank() == 0)
+                log_warn("watchdog: built without MPICPP_WATCHDOG, no operation is tracked");
+        }
+        if (m_notify)
+            post_notice_recv();
+        m_thread = std::thread([this]() { run(); });
+    }
+    watchdog(const watchdog &) = delete;
+    watchdog &operator=(const watchdog &) = delete;
+    ~watchdog()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+        if (m_notify)
+        {
+            // the notices are a few bytes and leave eagerly, then nobody sends any more
+            CHECK_MPI(MPI_Waitall(static_cast<int>(m_notice_sends.size()), m_notice_sends.data(),
+                                  MPI_STATUSES_IGNORE));
+            m_comm.barrier();
+            CHECK_MPI(MPI_Cancel(&m_notice_recv));
+            CHECK_MPI(MPI_Wait(&m_notice_recv, MPI_STATUS_IGNORE));
+        }
+        m_comm.free();
+    }
+
+    // number of stalls this rank has reported
+    std::size_t reports() const { return m_reports; }
+
+  private:
+    void report(const std::string &reason) const
+    {
+        auto lines = detail::outstanding_report(reason);
+        if (m_notify)
+        {
+            for (const auto &line : lines)
+            {
+                log_warn(line);
+            }
+            return;
+        }
+        if (!Logger::instance().enabled(LogLevel::Warning))
+            return;
+        std::chrono::duration<double> since = std::chrono::steady_clock::now() - m_log_clock;
+        auto prefix = Logger::prefix(m_rank, m_rank_length, m_log_time + since.count());
+        std::ostringstream oss;
+        for (const auto &line : lines)
+        {
+            oss << prefix << line << '\n';
+        }
+        std::cout << oss.str();
+        std::cout.flush();
+    }
+
+    void post_notice_recv()
+    {
+        CHECK_MPI(MPI_Irecv(&m_notice, 1, MPI_INT, MPI_ANY_SOURCE, 0, m_comm.data(), &m_notice_recv));
+    }
+
+    void run()
+    {
+        // a stall is reported once, identified by the start of its oldest operation
+        std::chrono::steady_clock::time_point reported{};
+        std::unique_lock lock(m_mutex);
+        while (!m_cv.wait_for(lock, m_options.interval, [this]() { return m_stop; }))
+        {
+            if (m_notify)
+                check_notices();
+            auto ops = outstanding_operations();
+            auto oldest = std::min_element(ops.begin(), ops.end(),
+                                           [](const auto &a, const auto &b) { return a.start < b.start; });
+            if (oldest == ops.end() || oldest->age() < m_options.threshold.count() || oldest->start == reported)
+                continue;
+            reported = oldest->start;
+            ++m_reports;
+            std::ostringstream reason;
+            reason << "watchdog: stalled for " << std::fixed << std::setprecision(3) << oldest->age() << " s";
+            report(reason.str());
+            if (m_notify)
+                notify_peers();
+        }
+    }
+
+    void check_notices()
+    {
+        int flag;
+        MPI_Status st;
+        CHECK_MPI(MPI_Test(&m_notice_recv, &flag, &st));
+        if (flag)
+        {
+            report("watchdog: rank " + std::to_string(st.MPI_SOURCE) + " stalled");
+            post_notice_recv();
+        }
+        if (m_notice_sends.empty())
+            return;
+        CHECK_MPI(MPI_Testall(static_cast<int>(m_notice_sends.size()), m_notice_sends.data(), &flag,
+                              MPI_STATUSES_IGNORE));
+        if (flag)
+            m_notice_sends.clear();
+    }
+
+    void notify_peers()
+    {
+        static const int notice = 0;
+        for (int r = 0; r < m_comm.size(); ++r)
+        {
+            if (r == m_comm.rank())
+                continue;
+            m_notice_sends.emplace_back();
+            CHECK_MPI(MPI_Isend(&notice, 1, MPI_INT, r, 0, m_comm.data(), &m_notice_sends.back()));
+        }
+    }
+};
+
+// collective: rank 0 logs the completion latencies of every operation, merged over the ranks of `comm`.
+inline void log_latency_histograms(const communicator &comm = world)
+{
+    auto local = latency_histograms();
+    std::array<latency_histogram, operation_count> merged;
+    for (std::size_t k = 0; k < operation_count; ++k)
+    {
+        comm.reduce(local[k].data(), merged[k].data(), latency_histogram::buckets, op::sum(), 0);
+    }
+    if (comm.rank() != 0)
+        return;
+    for (std::size_t k = 0; k < operation_count; ++k)
+    {
+        const auto &h = merged[k];
+        if (h.count() == 0)
+            continue;
+        std::ostringstream oss;
+        oss << std::left << std::setw(9) << to_string(static_cast<operation>(k)) << std::right << std::setw(10)
+            << h.count() << " ops, p50 < " << h.quantile(0.5) * 1e6 << " us, p99 < " << h.quantile(0.99) * 1e6
+            << " us, max < " << h.quantile(1.0) * 1e6 << " us |";
+        std::size_t last = latency_histogram::buckets;
+        while (last > 0 && h[last - 1] == 0)
+        {
+            --last;
+        }
+        for (std::size_t b = 0; b < last; ++b)
+        {
+            oss << ' ' << h[b];
+        }
+        log_info(oss.str());
+    }
+}
+
+} // end namespace mpi
+
+#endif // MPI_WATCHDOG_HPP
@@ -1,12 +1,18 @@
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <map>
 #include <mpi.hpp>
 #include <numeric>
+#include <random>
+#include <span>
 #include <thread>
 
 int main(int argc, char *argv[])
 {
-    mpi::environment env(argc, argv);
+    mpi::environment env(argc, argv, mpi::thread_level::multiple);
     mpi::log_init(mpi::LogLevel::Info);
 
     using mpi::world;
@@ -53,11 +59,498 @@ int main(int argc, char *argv[])
         world.reduce(world.rank(), mpi::op::custom<int, std::plus<int>>(true), 0);
     }
 
+    // a stateful functor gets an op of its own, std::plus above maps to MPI_SUM.
+    int modulus = 7, mod_sum = 0;
+    world.allreduce(world.rank() + 5, mod_sum, [modulus](int a, int b) { return (a + b) % modulus; }, true);
+    int plain_sum = world.size() * (world.size() - 1) / 2 + 5 * world.size();
+    int expected_mod = world.size() == 1 ? 5 : plain_sum % modulus;
+    mpi::log_info("sum of rank + 5 mod ", modulus, " = ", mod_sum, mod_sum == expected_mod ? " ok" : " failed");
+    // functors are not commutative unless told: keeping the left operand yields rank 0's value
+    int leftmost = 0;
+    world.allreduce(world.rank() + 10, leftmost, [](int a, int) { return a; });
+    mpi::log_info("leftmost ", leftmost == 10 ? "ok" : "failed");
+
+    // 1e16 + 1 + ... - 1e16 loses every 1 without compensation
+    auto partial = mpi::compensated_sum<double>::accumulate({world.rank() == 0 ? 1e16 : 0.0, 0.0}, 1.0);
+    partial = mpi::compensated_sum<double>::accumulate(partial, world.rank() == 0 ? -1e16 : 0.0);
+    mpi::compensated<double> total;
+    world.allreduce(partial, total, mpi::compensated_sum<double>{});
+    mpi::value_index<double> mine{double(world.rank() % 2), world.rank()}, best;
+    world.allreduce(mine, best, mpi::max_with_index<double>{});
+    bool reduced = total.value() == world.size() &&
+                   (world.size() == 1 ? best.value == 0 && best.index == 0 : best.value == 1 && best.index == 1);
+    mpi::log_info("compensated sum = ", total.value(), ", max with index = ", best.value, " at ", best.index,
+                  reduced ? " ok" : " failed");
+    std::vector<int> in_place(4, world.rank());
+    world.allreduce(static_cast<const int *>(MPI_IN_PLACE), in_place.data(), in_place.size(), mpi::op::sum());
+    mpi::log_info("in-place allreduce ", in_place[3] == world.size() * (world.size() - 1) / 2 ? "ok" : "failed");
+
     x.clear();
     x.resize(world.size(), world.rank());
     std::vector<int> y(world.size());
     world.alltoall(x.data(), y.data());
     int next_proc = (world.rank() + 1) % world.size();
     mpi::log_info("recv ", y[next_proc], " from rank ", next_proc);
+
+    // rank r holds the keys k with k % size == r, in reverse order.
+    std::vector<int> keys;
+    for (int k = 99; k >= 0; --k)
+    {
+        if (k % world.size() == world.rank())
+            keys.push_back(k);
+    }
+    mpi::sort(world, keys, std::less<int>{}, true);
+    auto part = mpi::block_partition(100, world.size());
+    bool sorted = keys.size() == part.size(world.rank());
+    for (std::size_t i = 0; sorted && i < keys.size(); ++i)
+    {
+        sorted = keys[i] == static_cast<int>(part.begin(world.rank()) + i);
+    }
+    mpi::log_info("sort: ", sorted ? "ok" : "failed");
+
+    mpi::distributed_vector<long> dv(world, 1000, 1);
+    auto prefix = dv.exclusive_scan(0);
+    bool scanned = true;
+    for (std::size_t i = 0; i < prefix.local_size(); ++i)
+    {
+        scanned = scanned && prefix[i] == static_cast<long>(prefix.to_global(i));
+    }
+    // everything to rank 0
+    std::vector<std::size_t> to_root(world.size() + 1, 1000);
+    to_root[0] = 0;
+    prefix.redistribute(to_root);
+    mpi::log_info("distributed_vector: sum = ", dv.reduce(), ", scan ", scanned ? "ok" : "failed",
+                  ", owner of 999 = ", dv.owner(999), ", local size after redistribute = ", prefix.local_size());
+
+    std::vector<double> weights(10000, world.rank() == 1 % world.size() ? 1.5 : 0.0), summed(10000);
+    mpi::pipelined_broadcast(world, weights, 1 % world.size(), 4096, mpi::pipeline::chain);
+    mpi::pipelined_reduce(world, weights.data(), summed.data(), weights.size(), std::plus<double>{}, 0, 4096);
+    // a non-commutative functor combines in rank order: keeping the left operand yields rank 0's values
+    std::vector<int> ranks(1000, world.rank() + 1), first(1000);
+    mpi::pipelined_reduce(world, ranks.data(), first.data(), ranks.size(), [](int a, int) { return a; }, 0, 1024);
+    if (world.rank() == 0)
+    {
+        bool ok = std::all_of(summed.begin(), summed.end(), [](double v) { return v == 1.5 * world.size(); }) &&
+                  std::all_of(first.begin(), first.end(), [](int v) { return v == 1; });
+        mpi::log_info("pipelined broadcast and reduce: ", ok ? "ok" : "failed");
+    }
+
+    long delivered = 0;
+    mpi::aggregator<long> agg(world, [&](int, const long *records, std::size_t count) {
+        delivered += std::accumulate(records, records + count, 0L);
+    });
+    for (int i = 0; i < 100; ++i)
+    {
+        agg.push(i % world.size(), 1);
+    }
+    agg.finish();
+    long all_delivered = 0;
+    world.allreduce(delivered, all_delivered, mpi::op::sum());
+    mpi::log_info("aggregator: delivered ", all_delivered, " of ", 100 * world.size(),
+                  all_delivered == 100 * world.size() ? " ok" : " failed");
+
+    // every rank sends its rank to the next one
+    std::map<int, std::vector<int>> outgoing{{(world.rank() + 1) % world.size(), {world.rank()}}};
+    auto incoming = mpi::sparse_exchange(world, outgoing);
+    int prev_proc = (world.rank() + world.size() - 1) % world.size();
+    bool exchanged = incoming.size() == 1 && incoming[prev_proc] == std::vector<int>{prev_proc};
+    mpi::log_info("sparse exchange: ", exchanged ? "ok" : "failed");
+
+    {
+        // a counter shard on every rank, incremented remotely; then fetch the next rank's shard.
+        mpi::active_messages am(world);
+        long shard = 0;
+        auto add = am.register_handler([&](long delta) { shard += delta; });
+        auto fetch = am.register_handler([&]() { return shard; });
+        auto greet = am.register_handler([](std::string who) { return "hello " + who; });
+        for (int r = 0; r < world.size(); ++r)
+        {
+            am.invoke(add, r, world.rank() + 1);
+        }
+        am.quiesce();
+        long remote = am.call(fetch, next_proc).get();
+        std::string greeting = am.call(greet, next_proc, "rank " + std::to_string(world.rank())).get();
+        am.quiesce();
+        bool ok = shard == world.size() * (world.size() + 1) / 2 && remote == shard;
+        mpi::log_info("active messages: ", ok ? "ok" : "failed", ", ", greeting);
+    }
+
+    {
+        // every task n > 0 spawns two tasks n - 1, rank 0 seeds one task 10: 2^11 - 1 tasks in total.
+        mpi::task_pool<int> pool(world, [](int &n, mpi::task_pool<int> &p) {
+            if (n > 0)
+            {
+                p.push(n - 1);
+                p.push(n - 1);
+            }
+        });
+        if (world.rank() == 0)
+            pool.push(10);
+        pool.run();
+        std::size_t executed = pool.stats().tasks_executed, all_executed = 0;
+        world.allreduce(executed, all_executed, mpi::op::sum());
+        mpi::log_info("task pool: executed ", executed, " of ", all_executed, all_executed == 2047 ? " ok" : " failed");
+    }
+
+    {
+        // broadcast into MPI_Alloc_mem memory, receive twice into a pooled buffer: the second reuses the block.
+        std::vector<int, mpi::alloc_mem_allocator<int>> values;
+        if (world.rank() == 0)
+            values.assign({1, 2, 3, 4});
+        world.broadcast(values, 0);
+        auto before = mpi::buffer_pool::instance().stats();
+        bool ok = values.size() == 4 && values[3] == 4;
+        for (int round = 0; round < 2; ++round)
+        {
+            if (world.rank() == 0)
+            {
+                world.send(std::vector<int>(values.begin(), values.end()), 1, 8);
+            }
+            else if (world.rank() == 1)
+            {
+                mpi::buffer<int> received;
+                world.recv(received, 0, 8);
+                ok = ok && std::equal(received.begin(), received.end(), values.begin(), values.end());
+            }
+        }
+        if (world.rank() == 1)
+            ok = ok && mpi::buffer_pool::instance().stats().hits > before.hits;
+        mpi::log_info("alloc_mem broadcast and pooled receive: ", ok ? "ok" : "failed");
+    }
+
+    {
+        // a matrix column and the interior of a grid, sent in place; received into a std::array and a sub-span.
+        constexpr int rows = 4, cols = 3;
+        std::array<int, rows * cols> matrix{};
+        std::iota(matrix.begin(), matrix.end(), 0);
+        std::array<int, rows> column{};
+        std::vector<int> interior(6, -1);
+        if (world.rank() == 0)
+        {
+            world.send(mpi::strided_view<const int>(matrix.data() + 1, rows, cols), 1, 9);
+            world.send(mpi::subarray_view(matrix.data(), {rows, cols}, {2, 2}, {1, 1}), 1, 9);
+        }
+        else if (world.rank() == 1)
+        {
+            world.recv(column, 0, 9);
+            world.recv(std::span(interior).subspan(1, 4), 0, 9);
+        }
+        std::array<int, 2> sums{}, local{1, world.rank()};
+        world.allreduce(local, sums, mpi::op::sum());
+        bool ok = sums[0] == world.size() && sums[1] == world.size() * (world.size() - 1) / 2;
+        if (world.rank() == 1)
+            ok = ok && column == std::array<int, rows>{1, 4, 7, 10} && interior == std::vector<int>{-1, 4, 5, 7, 8, -1};
+        mpi::log_info("ranges and datatype views: ", ok ? "ok" : "failed");
+    }
+
+    {
+        // x-slabs to y-slabs of a 5 x 4 x 3 array holding its global row-major index, with both methods.
+        const std::array<std::size_t, 3> shape{5, 4, 3};
+        auto from = mpi::slab_decomposition(shape, world.size(), 0);
+        auto to = mpi::slab_decomposition(shape, world.size(), 1);
+        const auto &mine = from[world.rank()], &target = to[world.rank()];
+        std::vector<int> src;
+        for (std::size_t i = mine.lo[0]; i < mine.hi[0]; ++i)
+        {
+            for (std::size_t j = 0; j < shape[1] * shape[2]; ++j)
+            {
+                src.push_back(static_cast<int>(i * shape[1] * shape[2] + j));
+            }
+        }
+        bool ok = true;
+        for (auto method : {mpi::redistribution_method::alltoallw, mpi::redistribution_method::packed})
+        {
+            mpi::redistribution_plan<int, 3> plan(world, from, to, method);
+            std::vector<int> dst(plan.target_size(), -1);
+            plan.execute(src.data(), dst.data());
+            std::size_t k = 0;
+            for (std::size_t i = 0; i < shape[0]; ++i)
+            {
+                for (std::size_t j = target.lo[1]; j < target.hi[1]; ++j)
+                {
+                    for (std::size_t l = 0; l < shape[2]; ++l)
+                    {
+                        ok = ok && dst[k++] == static_cast<int>((i * shape[1] + j) * shape[2] + l);
+                    }
+                }
+            }
+        }
+        mpi::log_info("slab transpose: ", ok ? "ok" : "failed");
+    }
+
+    {
+        // every allreduce algorithm on counts smaller than, equal to and larger than the rank count, and the table
+        bool ok = true;
+        for (std::size_t count : {std::size_t(1), std::size_t(world.size()), std::size_t(37)})
+        {
+            std::vector<long> local(count), result(count);
+            std::iota(local.begin(), local.end(), world.rank());
+            for (auto a : {mpi::allreduce_algorithm::recursive_doubling, mpi::allreduce_algorithm::ring,
+                           mpi::allreduce_algorithm::rabenseifner})
+            {
+                mpi::allreduce_with(a, world, local.data(), result.data(), count, mpi::op::sum());
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    long p = world.size();
+                    ok = ok && result[i] == p * static_cast<long>(i) + p * (p - 1) / 2;
+                }
+            }
+            std::vector<long> all(count * world.size(), world.rank()), swapped(count * world.size());
+            mpi::alltoall_pairwise(world, all.data(), swapped.data(), count);
+            for (std::size_t i = 0; i < swapped.size(); ++i)
+            {
+                ok = ok && swapped[i] == static_cast<long>(i / count);
+            }
+        }
+        mpi::tuning_table table;
+        table.parse("allreduce 4 64 ring\nallreduce 4 1024 rabenseifner\nalltoall 4 8 pairwise\n");
+        ok = ok && table.allreduce(4, 100) == mpi::allreduce_algorithm::rabenseifner &&
+             table.allreduce(4, 1 << 20) == mpi::allreduce_algorithm::rabenseifner &&
+             table.allreduce(3, 8) == mpi::allreduce_algorithm::library;
+        mpi::tuning_table copy;
+        copy.parse(table.str());
+        ok = ok && copy.str() == table.str();
+        mpi::log_info("tuned collectives: ", ok ? "ok" : "failed");
+    }
+
+    {
+        // smooth data compresses, random data travels raw; both must arrive bit for bit
+        const std::size_t n = 20000;
+        std::vector<double> smooth(n), noise(n), received(n);
+        std::mt19937_64 rng(42);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            smooth[i] = std::sin(i * 1e-3);
+            noise[i] = std::uniform_real_distribution<double>(-1, 1)(rng);
+        }
+        mpi::buffer<std::byte> encoded;
+        mpi::compress(smooth.data(), n, encoded);
+        bool ok = encoded.size() < n * sizeof(double) &&
+                  mpi::decompress(encoded.data(), encoded.size(), received.data(), n) && received == smooth;
+        for (const auto *data : {&smooth, &noise})
+        {
+            std::vector<double> copy = world.rank() == 0 ? *data : std::vector<double>(n);
+            ok = mpi::compressed_broadcast(world, copy.data(), n, 0) && ok && copy == *data;
+            if (world.rank() == 0)
+                mpi::compressed_send(world, data->data(), n, world.size() - 1, 10);
+            if (world.rank() == world.size() - 1)
+            {
+                ok = mpi::compressed_recv(world, received.data(), n, 0, 10) && ok && received == *data;
+            }
+        }
+        // a count mismatch is reported, not decoded into garbage
+        if (world.rank() == 0)
+            mpi::compressed_send(world, noise.data(), n, world.size() - 1, 10);
+        if (world.rank() == world.size() - 1)
+            ok = !mpi::compressed_recv(world, received.data(), n - 1000, 0, 10) && ok;
+        mpi::log_info("compressed transport: ", ok ? "ok" : "failed");
+    }
+
+    {
+        // rank r enters the inner region r + 1 times, rank 0 never enters "other"
+        for (int i = 0; i <= world.rank(); ++i)
+        {
+            mpi::scoped_timer outer("outer");
+            mpi::scoped_timer inner("inner");
+        }
+        if (world.rank() != 0)
+            mpi::scoped_timer other("other");
+        auto report = mpi::timer_report();
+        int p = world.size();
+        bool ok = report.size() == 3 && report[0].name == "other" && report[1].name == "outer" &&
+                  report[2].name == "outer/inner" && report[2].depth == 1 &&
+                  report[2].calls == static_cast<std::uint64_t>(p * (p + 1) / 2) && report[0].min == 0 &&
+                  report[1].imbalance >= 1;
+        mpi::log_timers();
+        mpi::log_info("region timers: ", ok ? "ok" : "failed");
+        mpi::timer_registry::instance().reset();
+
+        // names built at runtime may reuse the same address, they are told apart by content
+        for (int i = 0; i < 3; ++i)
+        {
+            mpi::scoped_timer phase(("phase" + std::to_string(i)).c_str());
+        }
+        report = mpi::timer_report();
+        ok = report.size() == 3 && report[2].name == "phase2" && report[2].calls == static_cast<std::uint64_t>(p);
+        mpi::log_info("runtime region names: ", ok ? "ok" : "failed");
+        mpi::timer_registry::instance().reset();
+    }
+
+    if (env.provided() == mpi::thread_level::multiple && world.size() >= 2)
+    {
+        // operation tracking (this test builds with MPICPP_WATCHDOG), the watchdog and the latency histograms
+        mpi::reset_latency_histograms();
+        int right = (world.rank() + 1) % world.size(), left = (world.rank() + world.size() - 1) % world.size();
+        int from_left = -1;
+        auto received = world.irecv(&from_left, 1, left, 9);
+        auto pending = mpi::outstanding_operations();
+        bool tracked = pending.size() == 1 && pending[0].kind == mpi::operation::irecv && pending[0].peer == left &&
+                       pending[0].tag == 9 && pending[0].bytes == sizeof(int);
+        world.send(world.rank(), right, 9);
+        received.wait();
+        // rank 0 sends late, the watchdog of rank 1 reports its blocked recv once
+        std::size_t reports;
+        {
+            mpi::watchdog dog(world, {std::chrono::duration<double>(0.1), std::chrono::milliseconds(10)});
+            int value = 0;
+            if (world.rank() == 0)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(300));
+                world.send(1, 1, 10);
+            }
+            else if (world.rank() == 1)
+            {
+                world.recv(value, 0, 10);
+            }
+            reports = dog.reports();
+        }
+        auto histograms = mpi::latency_histograms();
+        bool ok = tracked && from_left == left && mpi::outstanding_operations().empty() &&
+                  histograms[static_cast<int>(mpi::operation::irecv)].count() == 1 &&
+                  histograms[static_cast<int>(mpi::operation::send)].count() >= 1 &&
+                  reports == (world.rank() == 1 ? 1u : 0u);
+        mpi::log_latency_histograms();
+        mpi::log_info("watchdog: ", reports, " report(s), ", ok ? "ok" : "failed");
+    }
+
+    if (world.size() == 3)
+    {
+        // ranks 0 and 2 talk most, with two ranks per node they end up on the same node
+        mpi::communication_matrix traffic(world);
+        std::vector<char> payload(1000);
+        if (world.rank() == 0)
+        {
+            world.send(payload.data(), payload.size(), 2, 11);
+            world.recv(payload.data(), payload.size(), 2, 11);
+            world.recv(payload.data(), 8, 1, 11);
+        }
+        else if (world.rank() == 1)
+        {
+            world.send(payload.data(), 8, 0, 11);
+        }
+        else
+        {
+            world.recv(payload.data(), payload.size(), 0, 11);
+            world.send(payload.data(), payload.size(), 0, 11);
+        }
+        auto placed = mpi::reorder_ranks(traffic, {false, true, 2});
+        bool ok = placed.method == mpi::reorder_method::greedy && placed.total_bytes == 2008 &&
+                  placed.inter_node_bytes_before == 2000 && placed.inter_node_bytes_after == 8 &&
+                  placed.process == std::vector<int>{0, 2, 1} &&
+                  placed.process[placed.comm.rank()] == world.rank();
+        placed.comm.free();
+        mpi::log_info("rank reordering: ", mpi::to_string(placed.method), ", inter-node bytes ",
+                      placed.inter_node_bytes_before, " -> ", placed.inter_node_bytes_after, ok ? " ok" : " failed");
+    }
+
+    if (env.provided() == mpi::thread_level::multiple && world.size() >= 2 && world.rank() < 2)
+    {
+        // four threads each produce and release one partition, two rounds
+        constexpr std::size_t partitions = 4, count = 100;
+        std::vector<int> data(partitions * count);
+        bool ok = true;
+        if (world.rank() == 0)
+        {
+            mpi::partitioned_send<int> out(world, data.data(), partitions, count, 1, 20);
+            for (int round = 0; round < 2; ++round)
+            {
+                out.start();
+                std::vector<std::thread> producers;
+                for (std::size_t k = 0; k < partitions; ++k)
+                {
+                    producers.emplace_back([&, k]() {
+                        std::fill_n(data.begin() + k * count, count, round * 10 + static_cast<int>(k));
+                        out.ready(k);
+                    });
+                }
+                for (auto &t : producers)
+                {
+                    t.join();
+                }
+                out.wait();
+            }
+        }
+        else
+        {
+            mpi::partitioned_recv<int> in(world, data.data(), partitions, count, 0, 20);
+            for (int round = 0; round < 2; ++round)
+            {
+                in.start();
+                std::vector<bool> seen(partitions, false);
+                for (std::size_t done = 0; done < partitions;)
+                {
+                    for (std::size_t k = 0; k < partitions; ++k)
+                    {
+                        if (seen[k] || !in.arrived(k))
+                            continue;
+                        seen[k] = true;
+                        ++done;
+                        ok = ok && data[k * count] == round * 10 + static_cast<int>(k) &&
+                             data[k * count + count - 1] == round * 10 + static_cast<int>(k);
+                    }
+                }
+                in.wait();
+            }
+        }
+        mpi::log_info("partitioned communication: ", ok ? "ok" : "failed");
+    }
+
+    mpi::log_info("thread level: ", mpi::to_string(env.provided()));
+    if (env.provided() == mpi::thread_level::multiple)
+    {
+        // concurrent collectives, each thread on its own communicator
+        mpi::thread_communicators comms(world, 2);
+        int results[2] = {0, 0};
+        std::thread workers[2];
+        for (int t = 0; t < 2; ++t)
+        {
+            workers[t] = std::thread([&, t]() { comms[t].allreduce(world.rank() + t, results[t], mpi::op::sum()); });
+        }
+        for (auto &w : workers)
+        {
+            w.join();
+        }
+        int expected = world.size() * (world.size() - 1) / 2;
+        bool ok = results[0] == expected && results[1] == expected + world.size();
+        mpi::log_info("thread communicators: ", results[0], ", ", results[1], ok ? " ok" : " failed");
+    }
+
+    if (env.provided() == mpi::thread_level::multiple)
+    {
+        // a ring shift completed by the progress thread
+        mpi::progress_engine engine;
+        int right = (world.rank() + 1) % world.size(), left = (world.rank() + world.size() - 1) % world.size();
+        int incoming = -1, outgoing = world.rank();
+        auto received = engine.submit(world.irecv(&incoming, 1, left, 7));
+        auto sent = engine.submit(world.isend(&outgoing, 1, right, 7));
+        sent.wait();
+        int source = received.get_status().source();
+        // a request which has already completed (here: a null one) must not leave its waiter hanging
+        auto nothing = engine.submit(mpi::request{});
+        nothing.wait();
+        bool ok = incoming == left && source == left && nothing.ready();
+        mpi::log_info("progress engine: received ", incoming, " from ", source, ok ? " ok" : " failed");
+    }
+
+    // messages of more than INT_MAX elements, needs about 2.2 GB per rank.
+    if (std::getenv("MPICPP_TEST_LARGE_COUNT") && world.size() >= 2 && world.rank() < 2)
+    {
+        std::size_t count = (std::size_t(1) << 31) + 7;
+        std::vector<char> big(count);
+        if (world.rank() == 0)
+        {
+            big.front() = 'a';
+            big[count / 2] = 'b';
+            big.back() = 'c';
+            world.send(big.data(), count, 1, 1);
+        }
+        else
+        {
+            mpi::status st;
+            world.recv(big.data(), count, 0, 1, st);
+            bool ok = big.front() == 'a' && big[count / 2] == 'b' && big.back() == 'c';
+            mpi::log_info("large count recv: ", st.get_count_x<char>(), " elements, ", ok ? "ok" : "failed");
+        }
+    }
     return 0;
 }